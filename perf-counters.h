@@ -0,0 +1,158 @@
+#ifndef _PERF_COUNTERS_
+#define _PERF_COUNTERS_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+/*
+ * Hardware performance counters around a timed loop, through perf_event_open.
+ *
+ * The counters are only opened when the environment variable WND_PERF is set, e.g.
+ * WND_PERF=1 make plots. Each counter is opened on its own, so a counter the CPU or
+ * the kernel does not provide (or a perf_event_paranoid setting that forbids them)
+ * only makes that counter unavailable, and it is reported as NA.
+ */
+
+#define PERF_NUM_EVENTS 5
+
+const char* PERF_EVENT_NAMES[PERF_NUM_EVENTS] = {
+    "cycles", "instructions", "LLC misses", "branch misses", "dTLB misses"
+};
+
+bool PERF_WARNED[PERF_NUM_EVENTS]; // an unavailable counter is only reported once
+
+typedef struct {
+    int fds[PERF_NUM_EVENTS];
+    double values[PERF_NUM_EVENTS]; // NAN when the counter is not available
+} Perf_Counters;
+
+/*
+ * perf_event_config fills in the event of the i-th counter
+ */
+void perf_event_config(struct perf_event_attr* attr, int i) {
+    switch (i) {
+    case 0:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+    case 1:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+    case 2:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    case 3:
+        attr->type = PERF_TYPE_HARDWARE;
+        attr->config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    default:
+        attr->type = PERF_TYPE_HW_CACHE;
+        attr->config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        break;
+    }
+}
+
+void perf_counters_open(Perf_Counters* self) {
+    bool enabled = getenv("WND_PERF") != NULL;
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        self->fds[i] = -1;
+        self->values[i] = NAN;
+        if (!enabled) {
+            continue;
+        }
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        perf_event_config(&attr, i);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // the counters may have to share the hardware, these let us scale the counts
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        self->fds[i] = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (self->fds[i] < 0 && !PERF_WARNED[i]) {
+            printf("%s counter is not available\n", PERF_EVENT_NAMES[i]);
+            PERF_WARNED[i] = true;
+        }
+    }
+}
+
+void perf_counters_start(Perf_Counters* self) {
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        if (self->fds[i] >= 0) {
+            ioctl(self->fds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(self->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+/*
+ * perf_counters_stop freezes the counters, call it before taking the end time of the loop
+ */
+void perf_counters_stop(Perf_Counters* self) {
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        if (self->fds[i] >= 0) {
+            ioctl(self->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+/*
+ * perf_counters_read fills in the values of the stopped counters, call it after taking
+ * the end time of the loop, so that the reads are not part of the measured duration
+ */
+void perf_counters_read(Perf_Counters* self) {
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        self->values[i] = NAN;
+        uint64_t data[3]; // value, time enabled, time running
+        if (self->fds[i] < 0 || read(self->fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0) {
+            continue;
+        }
+        self->values[i] = ((double) data[0]) * data[1] / data[2];
+    }
+}
+
+void perf_counters_close(Perf_Counters* self) {
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        if (self->fds[i] >= 0) {
+            close(self->fds[i]);
+            self->fds[i] = -1;
+        }
+    }
+}
+
+/*
+ * perf_value_to_str writes a counter value divided by n_items, or NA when it is not available
+ * returns: the number of characters written
+ */
+int perf_value_to_str(double value, uint64_t n_items, char* out) {
+    if (isnan(value)) {
+        return sprintf(out, "NA");
+    }
+    return sprintf(out, "%.4f", value / n_items);
+}
+
+/*
+ * perf_counters_print prints the counters per item, in the style of the benchmark output
+ */
+void perf_counters_print(Perf_Counters* self, uint64_t n_items) {
+    char scratch[100];
+    for (int i = 0; i < PERF_NUM_EVENTS; i++) {
+        perf_value_to_str(self->values[i], n_items, scratch);
+        printf("%s per item = %s\n", PERF_EVENT_NAMES[i], scratch);
+    }
+}
+
+#endif // _PERF_COUNTERS_
@@ -2,6 +2,7 @@
 #define _UTILS_
 
 #include <stdio.h>
+#include <stdint.h>
 #include <assert.h>
 
 int u64_to_str_with_sep(uint64_t x, char sep, char* out) {
@@ -28,4 +29,18 @@ int u64_to_str_with_sep(uint64_t x, char sep, char* out) {
 	return c1 + 4;
 }
 
+#define RANDOM_SEED 88172645463325252ULL
+
+/*
+ * next_random advances a xorshift64 generator, so that the tests and benchmarks draw reproducible streams
+ * x: the state of the generator, start it at RANDOM_SEED (it must not be 0)
+ * returns: the next pseudo-random number
+ */
+uint64_t next_random(uint64_t* x) {
+	*x ^= *x << 13;
+	*x ^= *x >> 7;
+	*x ^= *x << 17;
+	return *x;
+}
+
 #endif // _UTILS_
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils.h"
+#include "window-bit-count-apx.h"
+
+#define W 1000000 // window size
+#define N 50000000 // stream length
+#define K 100 // relative error = 1 / K
+#define NUM_RATIOS 3
+#define NUM_P 3
+
+const uint32_t QUERY_EVERY[NUM_RATIOS] = { // items per query
+    1, 1000, 1000000
+};
+
+// density of ones: push does no work on a 0, while on the all-ones stream (the last one)
+// it still removes the expired buckets on every item
+const double P_OPTIONS[NUM_P] = {
+    0.01, 0.5, 1.0
+};
+
+uint64_t x = RANDOM_SEED;
+
+/*
+ * next_item draws an item that is 1 with probability p, encoded as p * 2^53
+ */
+bool next_item(uint64_t threshold) {
+    return (next_random(&x) >> 11) < threshold;
+}
+
+void print_result(uint32_t last_output, struct timespec tick, struct timespec tock, uint64_t memory) {
+    char scratch[100];
+
+    u64_to_str_with_sep(last_output, ',', scratch);
+    printf("last output = %s\n", scratch);
+
+    u64_to_str_with_sep(N_MERGES, ',', scratch);
+    printf("number of merges = %s\n", scratch);
+
+	uint64_t duration_nano = 1000000000L * (tock.tv_sec - tick.tv_sec) + tock.tv_nsec - tick.tv_nsec;
+    u64_to_str_with_sep(duration_nano, ',', scratch);
+	printf("duration = %s nanoseconds\n", scratch);
+
+	uint64_t throughput = (1000000000L * N) / duration_nano;
+    u64_to_str_with_sep(throughput, ',', scratch);
+	printf("throughput = %s items/sec\n", scratch);
+
+    u64_to_str_with_sep(memory, ',', scratch);
+    printf("memory footprint = %s bytes\n", scratch);
+
+    printf("\n");
+}
+
+int main() {
+    char scratch[100];
+
+    printf("**** BENCHMARK: Bit counting over a sliding window (approximate, push/query) *****\n");
+
+    u64_to_str_with_sep(N, ',', scratch);
+    printf("stream length = %s\n", scratch);
+
+    u64_to_str_with_sep(W, ',', scratch);
+    printf("window size = %s\n", scratch);
+
+    u64_to_str_with_sep(K, ',', scratch);
+    printf("k = %s\n", scratch);
+
+    printf("\n");
+
+    StateApx state;
+    uint64_t memory;
+    struct timespec tick, tock;
+    uint32_t last_output;
+
+    for (uint32_t j=0; j<NUM_P; j++) {
+        uint64_t threshold = (uint64_t) (P_OPTIONS[j] * (1ULL << 53));
+
+        printf("---- next (count after every item), p = %g -----\n", P_OPTIONS[j]);
+        N_MERGES = 0;
+        x = RANDOM_SEED;
+        memory = wnd_bit_count_apx_new(&state, W, K);
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        last_output = 0;
+        for (uint32_t i=1; i<=N; i++) {
+            last_output = wnd_bit_count_apx_next(&state, next_item(threshold));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        print_result(last_output, tick, tock, memory);
+        wnd_bit_count_apx_destruct(&state);
+
+        for (uint32_t r=0; r<NUM_RATIOS; r++) {
+            u64_to_str_with_sep(QUERY_EVERY[r], ',', scratch);
+            printf("---- push, query every %s items, p = %g -----\n", scratch, P_OPTIONS[j]);
+            N_MERGES = 0;
+            x = RANDOM_SEED;
+            memory = wnd_bit_count_apx_new(&state, W, K);
+            clock_gettime(CLOCK_MONOTONIC, &tick);
+            last_output = 0;
+            uint32_t until_query = QUERY_EVERY[r];
+            for (uint32_t i=1; i<=N; i++) {
+                wnd_bit_count_apx_push(&state, next_item(threshold));
+                until_query -= 1;
+                if (until_query == 0) {
+                    last_output = wnd_bit_count_apx_query(&state);
+                    until_query = QUERY_EVERY[r];
+                }
+            }
+            clock_gettime(CLOCK_MONOTONIC, &tock);
+            print_result(last_output, tick, tock, memory);
+            wnd_bit_count_apx_destruct(&state);
+        }
+    }
+
+    return 0;
+}
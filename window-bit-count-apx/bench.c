@@ -4,6 +4,7 @@
 #include <time.h>
 
 #include "../utils.h"
+#include "../perf-counters.h"
 #include "window-bit-count-apx.h"
 
 #define W 100000000 // window size
@@ -29,8 +30,12 @@ int main() {
     StateApx state;
     uint64_t memory = wnd_bit_count_apx_new(&state, W, K);
 
+    Perf_Counters counters;
+    perf_counters_open(&counters);
+
     struct timespec tick, tock;
 	clock_gettime(CLOCK_MONOTONIC, &tick);
+    perf_counters_start(&counters);
 
     uint32_t last_output = 0;
     for (uint32_t i=1; i<=N; i++) {
@@ -38,7 +43,10 @@ int main() {
         last_output = wnd_bit_count_apx_next(&state, item);
     }
 
+    perf_counters_stop(&counters);
     clock_gettime(CLOCK_MONOTONIC, &tock);
+    perf_counters_read(&counters);
+    perf_counters_close(&counters);
 
     u64_to_str_with_sep(last_output, ',', scratch);
     printf("last output = %s\n", scratch);
@@ -57,6 +65,8 @@ int main() {
     u64_to_str_with_sep(memory, ',', scratch);
     printf("memory footprint = %s bytes\n", scratch);
 
+    perf_counters_print(&counters, N);
+
     wnd_bit_count_apx_destruct(&state);
 
     return 0;
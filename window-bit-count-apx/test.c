@@ -2,6 +2,8 @@
 #include <math.h>
 #include <stdint.h>
 #include <assert.h>
+
+#include "../utils.h"
 #include "window-bit-count-apx.h"
 #include "../window-bit-count/window-bit-count.h"
 
@@ -9,6 +11,223 @@
 #define N 1000 // stream length
 #define K 100 // relative error = 1 / K
 
+/*
+ * test_push_query checks that pushing items and querying now and then gives
+ * the same counts as wnd_bit_count_apx_next
+ */
+void test_push_query() {
+    printf("**** TEST: Bit counting over a sliding window (approximate, push/query) *****\n");
+
+    uint32_t wnd_sizes[4] = {1, 10, W, 5000};
+    uint32_t k_options[3] = {1, 10, K};
+    uint32_t query_every[4] = {1, 7, 1000, 100000};
+    uint64_t x = RANDOM_SEED;
+    uint32_t last_output_apx = 0;
+
+    for (uint32_t a=0; a<4; a++) {
+        for (uint32_t b=0; b<3; b++) {
+            for (uint32_t c=0; c<4; c++) {
+                StateApx state_apx;
+                StateApx state_lazy;
+                wnd_bit_count_apx_new(&state_apx, wnd_sizes[a], k_options[b]);
+                wnd_bit_count_apx_new(&state_lazy, wnd_sizes[a], k_options[b]);
+
+                for (uint32_t i=1; i<=200*N; i++) {
+                    // the density of ones changes along the stream
+                    bool item = ((next_random(&x) >> 20) % 1000) < (i / (20*N)) * 100 + 50;
+                    last_output_apx = wnd_bit_count_apx_next(&state_apx, item);
+                    wnd_bit_count_apx_push(&state_lazy, item);
+                    if (i % query_every[c] == 0) {
+                        assert(wnd_bit_count_apx_query(&state_lazy) == last_output_apx);
+                    }
+                }
+                printf("W = %u, k = %u, query every %u items: last output = %u\n",
+                    wnd_sizes[a], k_options[b], query_every[c], last_output_apx);
+
+                wnd_bit_count_apx_destruct(&state_lazy);
+                wnd_bit_count_apx_destruct(&state_apx);
+            }
+        }
+    }
+}
+
+/*
+ * test_interleave mixes wnd_bit_count_apx_push, _query and _next on one state and checks
+ * that every count matches a state fed only through wnd_bit_count_apx_next
+ */
+void test_interleave() {
+    printf("**** TEST: Bit counting over a sliding window (approximate, interleaved) *****\n");
+
+    uint32_t wnd_sizes[3] = {10, 100, W};
+    uint32_t k_options[3] = {1, 10, K};
+    uint64_t x = RANDOM_SEED;
+
+    for (uint32_t a=0; a<3; a++) {
+        for (uint32_t b=0; b<3; b++) {
+            StateApx state_apx;
+            StateApx state_mixed;
+            wnd_bit_count_apx_new(&state_apx, wnd_sizes[a], k_options[b]);
+            wnd_bit_count_apx_new(&state_mixed, wnd_sizes[a], k_options[b]);
+
+            // a window full of ones, then half a window of zeros pushed, then next
+            uint32_t last_output_apx = 0;
+            for (uint32_t i=1; i<=wnd_sizes[a]; i++) {
+                last_output_apx = wnd_bit_count_apx_next(&state_apx, true);
+                wnd_bit_count_apx_push(&state_mixed, true);
+            }
+            for (uint32_t i=1; i<=wnd_sizes[a]/2; i++) {
+                last_output_apx = wnd_bit_count_apx_next(&state_apx, false);
+                wnd_bit_count_apx_push(&state_mixed, false);
+            }
+            assert(wnd_bit_count_apx_next(&state_mixed, false) == wnd_bit_count_apx_next(&state_apx, false));
+
+            // then runs of pushes, queries and nexts of random lengths
+            for (uint32_t i=1; i<=20*N; i++) {
+                uint64_t r = next_random(&x);
+                bool item = ((r >> 20) % 1000) < 300;
+                last_output_apx = wnd_bit_count_apx_next(&state_apx, item);
+                switch ((r >> 40) % 3) {
+                case 0:
+                    wnd_bit_count_apx_push(&state_mixed, item);
+                    break;
+                case 1:
+                    wnd_bit_count_apx_push(&state_mixed, item);
+                    assert(wnd_bit_count_apx_query(&state_mixed) == last_output_apx);
+                    break;
+                default:
+                    assert(wnd_bit_count_apx_next(&state_mixed, item) == last_output_apx);
+                    break;
+                }
+            }
+            printf("W = %u, k = %u: last output (interleaved) = %u\n",
+                wnd_sizes[a], k_options[b], last_output_apx);
+
+            wnd_bit_count_apx_destruct(&state_mixed);
+            wnd_bit_count_apx_destruct(&state_apx);
+        }
+    }
+}
+
+/*
+ * test_runs feeds sparse streams as runs of equal items
+ */
+void test_runs() {
+    printf("**** TEST: Bit counting over a sliding window (approximate, runs) *****\n");
+
+    uint32_t wnd_sizes[4] = {W, 1000, 5000, 100000};
+    uint32_t k_options[4] = {2, 10, 1, 10};
+    uint64_t x = RANDOM_SEED;
+
+    for (uint32_t a=0; a<4; a++) {
+        uint32_t wnd_sz = wnd_sizes[a];
+        uint32_t k = k_options[a];
+        State state;
+        StateApx state_apx;
+        StateApx state_run;
+        wnd_bit_count_new(&state, wnd_sz);
+        wnd_bit_count_apx_new(&state_apx, wnd_sz, k);
+        wnd_bit_count_apx_new(&state_run, wnd_sz, k);
+        uint32_t pool_size = state_run.pool->size;
+
+        // runs of 1s shorter than the memory pool take the same path as single items
+        for (uint32_t i=1; i<=N; i++) {
+            bool item = i % 2;
+            uint64_t run_length = 1 + (next_random(&x) >> 11) % (item ? pool_size - 1 : 2 * wnd_sz);
+            uint32_t last_output_apx = 0;
+            for (uint64_t j=0; j<run_length; j++) {
+                wnd_bit_count_next(&state, item);
+                last_output_apx = wnd_bit_count_apx_next(&state_apx, item);
+            }
+            assert(wnd_bit_count_apx_next_run(&state_run, item, run_length) == last_output_apx);
+        }
+
+        // long runs of 1s are inserted level by level, the buckets differ but not the guarantee
+        for (uint32_t i=1; i<=N; i++) {
+            bool item = i % 2;
+            uint64_t run_length = 1 + (next_random(&x) >> 11) % (3 * wnd_sz);
+            uint32_t last_output = 0;
+            for (uint64_t j=0; j<run_length; j++) {
+                last_output = wnd_bit_count_next(&state, item);
+            }
+            uint32_t last_output_run = wnd_bit_count_apx_next_run(&state_run, item, run_length);
+            assert(last_output >= last_output_run);
+            // the oldest item of the window is already counted as expired, allow for it
+            assert(k * (last_output - last_output_run) <= last_output + k);
+        }
+        printf("W = %u, k = %u: last output (runs) = %u\n", wnd_sz, k, state_run.prev_count);
+
+        wnd_bit_count_apx_destruct(&state_run);
+        wnd_bit_count_apx_destruct(&state_apx);
+        wnd_bit_count_destruct(&state);
+    }
+}
+
+/*
+ * test_long_runs feeds runs longer than INT_MAX, the timestamps must not wrap around
+ */
+void test_long_runs() {
+    printf("**** TEST: Bit counting over a sliding window (approximate, long runs) *****\n");
+
+    uint32_t wnd_sz = 1000;
+    uint32_t k = 10;
+    bool items[8] = {true, false, false, true, true, false, true, false};
+    uint64_t run_lengths[8] = {500, 3000000000ULL, 2000, 100, 3000000000ULL, 400, 5000000000ULL, 4294967296ULL};
+    State state;
+    StateApx state_run;
+    wnd_bit_count_new(&state, wnd_sz);
+    wnd_bit_count_apx_new(&state_run, wnd_sz, k);
+
+    for (uint32_t a=0; a<2; a++) {
+        for (uint32_t i=0; i<8; i++) {
+            uint32_t last_output = wnd_bit_count_next_run(&state, items[i], run_lengths[i]);
+            uint32_t last_output_run = wnd_bit_count_apx_next_run(&state_run, items[i], run_lengths[i]);
+            printf("run of %lu %u: last output (precise) = %u, last output (runs) = %u\n",
+                run_lengths[i], items[i], last_output, last_output_run);
+            assert(last_output >= last_output_run);
+            // the oldest item of the window is already counted as expired, allow for it
+            assert(k * (last_output - last_output_run) <= last_output + k);
+        }
+    }
+
+    // single items still count correctly afterwards
+    for (uint32_t i=1; i<=N; i++) {
+        uint32_t last_output = wnd_bit_count_next(&state, i % 2);
+        uint32_t last_output_apx = wnd_bit_count_apx_next(&state_run, i % 2);
+        assert(last_output >= last_output_apx);
+        assert(k * (last_output - last_output_apx) <= last_output + k);
+    }
+
+    wnd_bit_count_apx_destruct(&state_run);
+    wnd_bit_count_destruct(&state);
+}
+
+/*
+ * test_reset checks that a window that was reset counts like a new one
+ */
+void test_reset() {
+    printf("**** TEST: Bit counting over a sliding window (approximate, reset) *****\n");
+
+    StateApx state_apx;
+    StateApx state_reset;
+    wnd_bit_count_apx_new(&state_reset, W, K);
+    for (uint32_t i=1; i<=N; i++) {
+        wnd_bit_count_apx_next(&state_reset, i % 3);
+    }
+    wnd_bit_count_apx_reset(&state_reset);
+    wnd_bit_count_apx_new(&state_apx, W, K);
+
+    uint32_t last_output_apx = 0;
+    for (uint32_t i=1; i<=N; i++) {
+        bool item = (i % 7) < 4;
+        last_output_apx = wnd_bit_count_apx_next(&state_apx, item);
+        assert(wnd_bit_count_apx_next(&state_reset, item) == last_output_apx);
+    }
+    printf("last output (approximate) = %u\n", last_output_apx);
+
+    wnd_bit_count_apx_destruct(&state_apx);
+    wnd_bit_count_apx_destruct(&state_reset);
+}
+
 int main() {
     printf("**** TEST: Bit counting over a sliding window (approximate) *****\n");
 
@@ -47,5 +266,11 @@ int main() {
         wnd_bit_count_destruct(&state);
     }
 
+    test_push_query();
+    test_interleave();
+    test_runs();
+    test_long_runs();
+    test_reset();
+
     return 0;
 }
\ No newline at end of file
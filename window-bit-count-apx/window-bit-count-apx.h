@@ -7,8 +7,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <math.h>
+#include <inttypes.h>
 
-uint64_t N_MERGES = 0; // keep track of how many bucket merges occur
+_Thread_local uint64_t N_MERGES = 0; // keep track of how many bucket merges occur (per thread)
 
 /*
     TODO: You can add code here.
@@ -16,7 +17,7 @@ uint64_t N_MERGES = 0; // keep track of how many bucket merges occur
 typedef struct Bucket {
     int count;
     int group_count;
-    int timestamp;
+    int64_t timestamp; // 64-bit, so that long runs of 0s cannot wrap it around
     struct Bucket* next;
     struct Bucket* prev;
     struct Bucket* group_head;
@@ -40,14 +41,14 @@ typedef struct Memory_Pool {
  * pool: the memory pool
  * size: the size of the memory pool
  * returns: the size of the memory pool
+ *
+ * calloc marks every bucket as unused, and for a large pool it gets pages from the
+ * kernel that are zeroed lazily, so the buckets are not touched here.
  */
 int init_memory_pool(Memory_Pool *pool, int size) {
    pool->size = size;
-   pool->bucket_pool = (Bucket*)malloc(size * sizeof(Bucket));
+   pool->bucket_pool = (Bucket*)calloc(size, sizeof(Bucket));
    pool->current = 0;
-    for (int i = 0; i < size; i++) {
-         pool->bucket_pool[i].used = false;
-    }
    return size * sizeof(Bucket);
 }
 
@@ -98,9 +99,15 @@ typedef struct {
     u_int64_t k;
     Bucket *head;
     Bucket *tail;
-    int time;
+    int64_t time;
     Memory_Pool *pool;
     int prev_count;
+    bool count_stale; // items were pushed since prev_count was computed
+    // scratch space of insert_run_of_ones, allocated by the first long run of 1s
+    int64_t *run_old_ts;   // pool->size timestamps
+    int64_t *run_seq_ts;   // min(pool->size, 2k + 4) timestamps
+    int64_t *run_carry_ts; // min(pool->size, 2k + 4) timestamps
+    int64_t *run_group_ts; // min(pool->size, k + 2) timestamps
 } StateApx;
 
 // k = 1/eps
@@ -118,6 +125,7 @@ uint64_t wnd_bit_count_apx_new(StateApx* self, uint32_t wnd_size, uint32_t k) {
     self -> head = NULL;
     self -> tail = NULL;
     self -> prev_count = 0;
+    self -> count_stale = false;
 //    int mem_size = init_memory_pool(self -> pool, wnd_size);
 //    // TODO:
 //    // The function should return the total number of bytes allocated on the heap.
@@ -133,9 +141,11 @@ uint64_t wnd_bit_count_apx_new(StateApx* self, uint32_t wnd_size, uint32_t k) {
         int n = ceil(log2((double)wnd_size / (double)(k + 1) + 1) - 1);
         memory_size = (n + 1) * (k + 1) + 1;
     }
+    self -> run_old_ts = NULL;
+    self -> run_seq_ts = NULL;
+    self -> run_carry_ts = NULL;
+    self -> run_group_ts = NULL;
     return init_memory_pool(self->pool, memory_size) + sizeof(Memory_Pool);
-
-
 }
 
 void destroy_memory_pool(Memory_Pool *pool)
@@ -156,6 +166,34 @@ void wnd_bit_count_apx_destruct(StateApx* self) {
     self -> wnd_size = 0;
     self -> prev_count = 0;
     destroy_memory_pool(self -> pool);
+    free(self -> pool);
+    self -> pool = NULL;
+    free(self -> run_old_ts);
+    self -> run_old_ts = NULL;
+    self -> run_seq_ts = NULL;
+    self -> run_carry_ts = NULL;
+    self -> run_group_ts = NULL;
+}
+
+/*
+ * wnd_bit_count_apx_reset empties the window and keeps the memory pool for the next stream
+ *
+ * Only the buckets in the list are given back to the pool, so this takes time in the
+ * number of live buckets, not in the size of the pool.
+ */
+void wnd_bit_count_apx_reset(StateApx* self) {
+    Bucket *current = self->head;
+    while (current != NULL) {
+        Bucket *next = current->next;
+        free_bucket(current);
+        current = next;
+    }
+    self -> head = NULL;
+    self -> tail = NULL;
+    self -> time = -1;
+    self -> prev_count = 0;
+    self -> count_stale = false;
+    self -> pool -> current = 0;
 }
 
 /*
@@ -168,7 +206,7 @@ void wnd_bit_count_apx_print(StateApx* self) {
     // This is useful for debugging.
     Bucket *current = self->head;
     while (current != NULL) {
-        printf("{%lu, %d}", current->timestamp, current->count);
+        printf("{%" PRId64 ", %d}", current->timestamp, current->count);
         if (current->next != NULL) {
             printf(" -> ");
         }
@@ -225,7 +263,7 @@ bool merge_buckets(StateApx* self, Bucket* current) {
     return is_merged;
 }
 
-bool check_remove_tail(StateApx* self, Bucket* tail, int min_time) {
+bool check_remove_tail(StateApx* self, Bucket* tail, int64_t min_time) {
     bool is_removed = false;
     if (tail != NULL && tail->timestamp <= min_time) {
         is_removed = true;
@@ -256,6 +294,14 @@ bool check_remove_tail(StateApx* self, Bucket* tail, int min_time) {
     return is_removed;
 }
 
+/*
+ * expire_buckets removes all the buckets that have left the window
+ */
+void expire_buckets(StateApx* self, int64_t min_time) {
+    while (check_remove_tail(self, self->tail, min_time)) {
+    }
+}
+
 int count_bits(StateApx* self, Bucket* current) {
     int count = 0;
     while (current != NULL) {
@@ -288,6 +334,12 @@ int count_bits(StateApx* self, Bucket* current) {
  */
 uint32_t wnd_bit_count_apx_next(StateApx* self, bool item) {
     // TODO: Fill me.
+    if (self->count_stale) {
+        // items were pushed since the last count, remove what they left behind and recount
+        expire_buckets(self, self->time - self->wnd_size + 1);
+        self->prev_count = count_bits(self, self->head);
+        self->count_stale = false;
+    }
     self -> time++;
     bool is_merged = false;
     bool is_removed = false;
@@ -305,7 +357,7 @@ uint32_t wnd_bit_count_apx_next(StateApx* self, bool item) {
         is_merged = merge_buckets(self, current);
     }
     //wnd_bit_count_apx_print(self);
-    int min_time = self->time - self->wnd_size + 1;
+    int64_t min_time = self->time - self->wnd_size + 1;
 
     Bucket *tail = self->tail;
     is_removed = check_remove_tail(self, tail, min_time);
@@ -322,4 +374,277 @@ uint32_t wnd_bit_count_apx_next(StateApx* self, bool item) {
     return self->prev_count;
 }
 
+/*
+ * wnd_bit_count_apx_push adds the next item to the window without computing the count
+ * self: the state of the algorithm
+ * item: the next item in the stream
+ *
+ * Only the bucket insertion and the merges are done here, the count is left to
+ * wnd_bit_count_apx_query. Buckets that left the window are not removed on every item:
+ * a 0 does no work at all, and a 1 removes them only before it takes a bucket from the
+ * memory pool, which is sized for the buckets of a single window. Use this when the count
+ * is needed much less often than once per item. It can be mixed freely with
+ * wnd_bit_count_apx_next, which catches up with the pushed items first.
+ */
+void wnd_bit_count_apx_push(StateApx* self, bool item) {
+    self->count_stale = true;
+    if (item) {
+        // catch up with what wnd_bit_count_apx_next would have removed until the previous item,
+        // so that both build the same buckets
+        expire_buckets(self, self->time - self->wnd_size + 1);
+    }
+    self -> time++;
+    if (item) {
+        Bucket *new_bucket = malloc_bucket(self->pool);
+        new_bucket->timestamp = self->time;
+        new_bucket->count = 1;
+        new_bucket->prev = NULL;
+        add_bucket_to_group(new_bucket, self->head);
+        self->head = new_bucket;
+        if (self->tail == NULL) {
+            self->tail = new_bucket;
+        }
+        merge_buckets(self, new_bucket);
+    }
+}
+
+/*
+ * wnd_bit_count_apx_query removes the buckets that left the window since the last query
+ * and computes the count
+ * self: the state of the algorithm
+ * returns: the count of the bits in the window
+ */
+uint32_t wnd_bit_count_apx_query(StateApx* self) {
+    expire_buckets(self, self->time - self->wnd_size + 1);
+    self->prev_count = count_bits(self, self->head);
+    self->count_stale = false;
+    return self->prev_count;
+}
+
+/*
+ * wnd_bit_count_apx_next_batch feeds a buffer of bit-packed items into the window
+ * self: the state of the algorithm
+ * bits: the items, 8 per byte, least significant bit first
+ * n_items: the number of items in the buffer
+ * returns: the count of the bits in the window after the last item
+ */
+uint32_t wnd_bit_count_apx_next_batch(StateApx* self, const uint8_t* bits, uint64_t n_items) {
+    for (uint64_t i = 0; i < n_items; i++) {
+        bool item = (bits[i >> 3] >> (i & 7)) & 1;
+        wnd_bit_count_apx_push(self, item);
+    }
+    return wnd_bit_count_apx_query(self);
+}
+
+/*
+ * Run_Seq is the sequence of timestamps of the buckets entering one level during a run
+ * of 1s: an explicit part (oldest first) followed by an arithmetic progression.
+ */
+typedef struct {
+    int64_t* explicit_ts;
+    int n_explicit;
+    int64_t first; // first timestamp of the progression
+    int64_t step;
+    uint64_t n; // length of the progression
+} Run_Seq;
+
+int64_t run_seq_at(Run_Seq* seq, uint64_t i) {
+    if (i < (uint64_t) seq->n_explicit) {
+        return seq->explicit_ts[i];
+    }
+    return seq->first + seq->step * (int64_t) (i - seq->n_explicit);
+}
+
+/*
+ * append_group appends a group of buckets at the tail of the list
+ * ts: the timestamps of the buckets, oldest first
+ */
+void append_group(StateApx* self, int count, int64_t* ts, int n) {
+    Bucket *group_head = NULL;
+    for (int i = n - 1; i >= 0; i--) {
+        Bucket *bucket = malloc_bucket(self->pool);
+        bucket->count = count;
+        bucket->timestamp = ts[i];
+        bucket->prev = self->tail;
+        if (self->tail != NULL) {
+            self->tail->next = bucket;
+        } else {
+            self->head = bucket;
+        }
+        self->tail = bucket;
+        if (group_head == NULL) {
+            group_head = bucket;
+        }
+    }
+    group_head->group_count = n;
+    group_head->group_tail = self->tail;
+    self->tail->group_head = group_head;
+}
+
+/*
+ * run_seq_capacity is the number of timestamps a level of insert_run_of_ones holds explicitly:
+ * its own buckets plus the merged ones coming from below, at most 2k + 4, and never more
+ * than there were buckets before the run
+ */
+uint64_t run_seq_capacity(StateApx* self) {
+    uint64_t capacity = 2 * self->k + 4;
+    return capacity < (uint64_t) self->pool->size ? capacity : (uint64_t) self->pool->size;
+}
+
+/*
+ * alloc_run_scratch allocates the scratch arrays of insert_run_of_ones in one block
+ * returns: the number of bytes allocated
+ */
+uint64_t alloc_run_scratch(StateApx* self) {
+    uint64_t n_old = self->pool->size;
+    uint64_t n_seq = run_seq_capacity(self);
+    uint64_t n_group = self->k + 2 < n_old ? self->k + 2 : n_old;
+    uint64_t n_scratch = n_old + 2 * n_seq + n_group;
+    self->run_old_ts = (int64_t*) malloc(n_scratch * sizeof(int64_t));
+    self->run_seq_ts = self->run_old_ts + n_old;
+    self->run_carry_ts = self->run_seq_ts + n_seq;
+    self->run_group_ts = self->run_carry_ts + n_seq;
+    return n_scratch * sizeof(int64_t);
+}
+
+/*
+ * insert_run_of_ones adds run_length 1s to the window without going through the
+ * merges of every single 1.
+ *
+ * Feeding the 1s one by one, each level only sees the buckets coming from the level below,
+ * oldest first, and it merges its oldest two buckets whenever it holds k + 2 of them.
+ * So the buckets of a level end up being the newest k or k + 1 of its input (depending on
+ * the parity), and the merged buckets it passes up are every second bucket of the rest.
+ * The new 1s enter level 0 as timestamps time + 1, time + 2, ..., and every second element
+ * of an arithmetic progression is again an arithmetic progression, so each level is
+ * computed in O(k) time no matter how long the run is, and the list is rebuilt from
+ * the result in O(k log(W)). The timestamps are kept in scratch arrays of the state, which
+ * are allocated by the first call only, so states that never see a long run of 1s do not pay
+ * for them.
+ */
+void insert_run_of_ones(StateApx* self, uint64_t run_length) {
+    if (self->run_old_ts == NULL) {
+        alloc_run_scratch(self);
+    }
+    int64_t end = self->time + run_length;
+    if (run_length >= self->wnd_size) {
+        // the buckets in the list would all leave the window during the run
+        expire_buckets(self, INT64_MAX);
+        run_length = self->wnd_size;
+        self->time = end - run_length;
+    } else {
+        expire_buckets(self, end - self->wnd_size + 1);
+    }
+
+    // copy the timestamps of the buckets out, newest first, and give the buckets back to the pool
+    int64_t* old_ts = self->run_old_ts;
+    int level_start[64];
+    int n_levels = 0;
+    int n_old = 0;
+    Bucket *current = self->head;
+    while (current != NULL) {
+        assert(n_levels < 63 && current->count == (1 << n_levels));
+        level_start[n_levels] = n_old;
+        n_levels++;
+        Bucket *group_end = current->group_tail->next;
+        while (current != group_end) {
+            Bucket *next = current->next;
+            old_ts[n_old] = current->timestamp;
+            n_old++;
+            free_bucket(current);
+            current = next;
+        }
+    }
+    level_start[n_levels] = n_old;
+    self->head = NULL;
+    self->tail = NULL;
+
+    uint64_t capacity = run_seq_capacity(self);
+    int64_t* seq_ts = self->run_seq_ts;
+    int64_t* carry_ts = self->run_carry_ts;
+    int64_t* group_ts = self->run_group_ts;
+    int n_carry = 0;
+    Run_Seq seq;
+    seq.explicit_ts = seq_ts;
+    seq.first = self->time + 1;
+    seq.step = 1;
+    seq.n = run_length;
+
+    for (int level = 0; level < n_levels || n_carry > 0 || seq.n > 0; level++) {
+        // input of the level: its own buckets, oldest first, then what comes from below
+        seq.n_explicit = 0;
+        if (level < n_levels) {
+            for (int i = level_start[level + 1] - 1; i >= level_start[level]; i--) {
+                seq_ts[seq.n_explicit] = old_ts[i];
+                seq.n_explicit++;
+            }
+        }
+        for (int i = 0; i < n_carry; i++) {
+            seq_ts[seq.n_explicit] = carry_ts[i];
+            seq.n_explicit++;
+        }
+        assert((uint64_t) seq.n_explicit <= capacity);
+
+        uint64_t total = seq.n_explicit + seq.n;
+        uint64_t n_keep = total;
+        uint64_t n_pairs = 0;
+        if (total > self->k + 1) {
+            n_keep = (total - (self->k + 1)) % 2 == 0 ? self->k + 1 : self->k;
+            n_pairs = (total - n_keep) / 2;
+        }
+        N_MERGES += n_pairs;
+
+        for (uint64_t i = 0; i < n_keep; i++) {
+            group_ts[i] = run_seq_at(&seq, total - n_keep + i);
+        }
+        if (n_keep > 0) {
+            append_group(self, 1 << level, group_ts, (int) n_keep);
+        }
+
+        // every pair is merged into a bucket with the timestamp of its newer half
+        uint64_t first_in_progression = seq.n_explicit / 2;
+        n_carry = 0;
+        for (uint64_t i = 0; i < n_pairs && i < first_in_progression; i++) {
+            carry_ts[n_carry] = run_seq_at(&seq, 2 * i + 1);
+            n_carry++;
+        }
+        if (n_pairs > first_in_progression) {
+            seq.first = run_seq_at(&seq, 2 * first_in_progression + 1);
+            seq.step *= 2;
+            seq.n = n_pairs - first_in_progression;
+        } else {
+            seq.n = 0;
+        }
+    }
+
+    self->time = end;
+}
+
+/*
+ * wnd_bit_count_apx_next_run feeds a run of equal items into the window
+ * self: the state of the algorithm
+ * item: the value of the items
+ * run_length: the number of items
+ * returns: the count of the bits in the window after the last item
+ *
+ * A run of 0s only moves the time forward and removes the buckets that left the window.
+ * A run of 1s that is longer than the memory pool is inserted level by level
+ * (see insert_run_of_ones), shorter ones are pushed one by one. Either way the cost
+ * does not grow with the length of the run beyond O(k log(W)). The first long run of 1s
+ * allocates the scratch arrays of insert_run_of_ones, about 8 bytes per bucket of the pool,
+ * which are not part of the memory reported by wnd_bit_count_apx_new.
+ */
+uint32_t wnd_bit_count_apx_next_run(StateApx* self, bool item, uint64_t run_length) {
+    if (!item) {
+        self->time += run_length;
+    } else if (run_length < (uint64_t) self->pool->size) {
+        for (uint64_t i = 0; i < run_length; i++) {
+            wnd_bit_count_apx_push(self, true);
+        }
+    } else {
+        insert_run_of_ones(self, run_length);
+    }
+    return wnd_bit_count_apx_query(self);
+}
+
 #endif // _WINDOW_BIT_COUNT_APX_
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils.h"
+#include "window-bit-count-ingest.h"
+
+#define W 1000000 // window size
+#define K 100 // relative error = 1 / K
+#define NUM_FILES 128
+#define FILE_SIZE (512*1024) // bytes per trace file
+#define BUF_SIZE (64*1024) // bytes per buffer
+#define NUM_BUFS 32
+
+char dir[] = "/tmp/window-bit-count-ingest-bench-XXXXXX";
+char paths[NUM_FILES][128];
+const char* path_ptrs[NUM_FILES];
+
+void write_traces() {
+    assert(mkdtemp(dir) != NULL);
+    uint8_t* data = (uint8_t*) malloc(FILE_SIZE);
+    uint64_t x = RANDOM_SEED;
+    for (uint32_t i=0; i<NUM_FILES; i++) {
+        for (uint32_t j=0; j<FILE_SIZE; j++) {
+            data[j] = (uint8_t) next_random(&x);
+        }
+        sprintf(paths[i], "%s/trace-%u", dir, i);
+        path_ptrs[i] = paths[i];
+        FILE* stream = fopen(paths[i], "wb");
+        if (stream == NULL) {
+            printf("%s could not be opened.\n", paths[i]);
+            exit(1);
+        }
+        fwrite(data, 1, FILE_SIZE, stream);
+        fclose(stream);
+    }
+    free(data);
+}
+
+void remove_traces() {
+    for (uint32_t i=0; i<NUM_FILES; i++) {
+        unlink(paths[i]);
+    }
+    rmdir(dir);
+}
+
+void execute(uint32_t k, bool use_uring, uint32_t n_workers) {
+    char scratch[100];
+
+    printf("**** BENCHMARK: Bit counting over a sliding window (ingest pipeline) *****\n");
+
+    printf("engine = %s\n", k == 0 ? "exact" : "approximate");
+    printf("backend = %s\n", use_uring ? "io_uring" : "reader threads");
+    printf("workers = %u\n", n_workers);
+
+    Ingest ingest;
+    uint64_t memory = ingest_new(&ingest, path_ptrs, NUM_FILES, W, k, n_workers, NUM_BUFS, BUF_SIZE, use_uring);
+    if (ingest_run(&ingest) != 0) {
+        printf("ingest failed\n");
+        exit(1);
+    }
+
+    u64_to_str_with_sep(ingest.bytes, ',', scratch);
+    printf("bytes = %s\n", scratch);
+
+    u64_to_str_with_sep(ingest.duration_nano, ',', scratch);
+    printf("duration = %s nanoseconds\n", scratch);
+
+    printf("throughput = %.3f GB/s\n", ((double) ingest.bytes) / ingest.duration_nano);
+
+    uint64_t throughput = (1000000000L * 8 * ingest.bytes) / ingest.duration_nano;
+    u64_to_str_with_sep(throughput, ',', scratch);
+    printf("throughput = %s items/sec\n", scratch);
+
+    if (k > 0) {
+        u64_to_str_with_sep(ingest.n_merges, ',', scratch);
+        printf("number of merges = %s\n", scratch);
+    }
+
+    u64_to_str_with_sep(memory, ',', scratch);
+    printf("memory footprint = %s bytes\n", scratch);
+
+    printf("\n");
+
+    ingest_destruct(&ingest);
+}
+
+int main() {
+    char scratch[100];
+
+    uint32_t n_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n_workers > 1) {
+        n_workers -= 1; // leave a core for the thread issuing reads
+    }
+
+    u64_to_str_with_sep(NUM_FILES, ',', scratch);
+    printf("files = %s\n", scratch);
+
+    u64_to_str_with_sep(FILE_SIZE, ',', scratch);
+    printf("file size = %s bytes\n", scratch);
+
+    u64_to_str_with_sep(W, ',', scratch);
+    printf("window size = %s\n", scratch);
+
+    printf("\n");
+
+    write_traces();
+
+    execute(0, true, n_workers);
+    execute(0, false, n_workers);
+    execute(K, true, n_workers);
+    execute(K, false, n_workers);
+
+    remove_traces();
+
+    return 0;
+}
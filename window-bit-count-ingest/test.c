@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "../utils.h"
+#include "window-bit-count-ingest.h"
+
+#define W 1000 // window size
+#define K 100 // relative error = 1 / K
+#define NUM_FILES 9
+#define BUF_SIZE 4096 // bytes per buffer
+#define NUM_BUFS 4
+
+/*
+ * write_trace writes a trace file of n_bytes pseudo-random bytes
+ * returns: the path of the file in out
+ */
+void write_trace(char* out, uint32_t seed, uint32_t n_bytes) {
+    sprintf(out, "/tmp/window-bit-count-ingest-test-XXXXXX");
+    int fd = mkstemp(out);
+    assert(fd >= 0);
+    uint64_t x = RANDOM_SEED + seed;
+    for (uint32_t i=0; i<n_bytes; i++) {
+        uint8_t byte = (uint8_t) next_random(&x);
+        assert(write(fd, &byte, 1) == 1);
+    }
+    close(fd);
+}
+
+/*
+ * expected_output feeds a trace file item by item into a fresh window
+ */
+uint32_t expected_output(const char* path, uint32_t k) {
+    FILE* stream = fopen(path, "rb");
+    assert(stream != NULL);
+
+    State state;
+    StateApx state_apx;
+    if (k == 0) {
+        wnd_bit_count_new(&state, W);
+    } else {
+        wnd_bit_count_apx_new(&state_apx, W, k);
+    }
+
+    uint32_t last_output = 0;
+    int c;
+    while ((c = fgetc(stream)) != EOF) {
+        for (uint32_t b=0; b<8; b++) {
+            bool item = (c >> b) & 1;
+            if (k == 0) {
+                last_output = wnd_bit_count_next(&state, item);
+            } else {
+                last_output = wnd_bit_count_apx_next(&state_apx, item);
+            }
+        }
+    }
+    fclose(stream);
+
+    if (k == 0) {
+        wnd_bit_count_destruct(&state);
+    } else {
+        wnd_bit_count_apx_destruct(&state_apx);
+    }
+    return last_output;
+}
+
+int main() {
+    printf("**** TEST: Bit counting over a sliding window (ingest pipeline) *****\n");
+
+    char paths[NUM_FILES][64];
+    const char* path_ptrs[NUM_FILES];
+    for (uint32_t i=0; i<NUM_FILES; i++) {
+        // empty files, files smaller than a buffer and files spanning many buffers
+        write_trace(paths[i], i, i * 3001);
+        path_ptrs[i] = paths[i];
+    }
+
+    uint32_t k_options[2] = {0, K};
+    for (uint32_t use_uring=0; use_uring<=1; use_uring++) {
+        for (uint32_t n_workers=1; n_workers<=3; n_workers++) {
+            for (uint32_t j=0; j<2; j++) {
+                uint32_t k = k_options[j];
+                Ingest ingest;
+                ingest_new(&ingest, path_ptrs, NUM_FILES, W, k, n_workers, NUM_BUFS, BUF_SIZE, use_uring);
+                assert(ingest_run(&ingest) == 0);
+
+                // the workers count their merges on their own threads, this thread counts them again
+                N_MERGES = 0;
+                uint64_t bytes = 0;
+                for (uint32_t i=0; i<NUM_FILES; i++) {
+                    uint32_t output = ingest_output(&ingest, i);
+                    uint32_t expected = expected_output(paths[i], k);
+                    printf("uring = %u, workers = %u, k = %u, file %u: output = %u, expected = %u\n",
+                        use_uring, n_workers, k, i, output, expected);
+                    assert(output == expected);
+                    bytes += i * 3001;
+                }
+                assert(ingest.bytes == bytes);
+                assert(ingest.n_merges == N_MERGES);
+
+                ingest_destruct(&ingest);
+            }
+        }
+    }
+
+    for (uint32_t i=0; i<NUM_FILES; i++) {
+        unlink(paths[i]);
+    }
+
+    return 0;
+}
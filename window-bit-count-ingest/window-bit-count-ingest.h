@@ -0,0 +1,627 @@
+#ifndef _WINDOW_BIT_COUNT_INGEST_
+#define _WINDOW_BIT_COUNT_INGEST_
+
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "../window-bit-count/window-bit-count.h"
+#include "../window-bit-count-apx/window-bit-count-apx.h"
+
+/*
+ * Ingest pipeline: counts bits over a sliding window for many trace files at once.
+ *
+ * A trace file is a raw stream of bit-packed items (8 per byte, least significant
+ * bit first), and every file gets its own window state. The calling thread issues
+ * reads through io_uring (or through a pool of reader threads calling pread when
+ * io_uring is not available) into a fixed pool of buffers. Filled buffers are handed
+ * to worker threads, which run the batch API of the exact (k == 0) or approximate
+ * engine and give the buffer back to the pool, so no memory is allocated per read.
+ *
+ * Items of one file must be consumed in order, so every file has at most one read in
+ * flight and always goes to the same worker (file % n_workers), whose queue is FIFO.
+ * Parallelism comes from having many files.
+ *
+ * N_MERGES is thread local, so every worker counts the merges of its own files, and
+ * the counts are added up into Ingest.n_merges when the workers exit.
+ */
+
+#define INGEST_QUEUE_DEPTH 64 // io_uring entries, also the cap on reads in flight
+#define INGEST_STOP UINT32_MAX // job.file value that tells a thread to exit
+
+typedef struct {
+    uint32_t file;
+    uint32_t buf;
+    uint64_t offset;
+    int64_t n_bytes; // bytes requested, or the result of the read once completed
+} Ingest_Job;
+
+/*
+ * Ingest_Queue is a blocking FIFO of jobs.
+ * Its capacity is the number of buffers, and every job owns a buffer,
+ * so pushing never has to wait.
+ */
+typedef struct {
+    Ingest_Job* jobs;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+} Ingest_Queue;
+
+/*
+ * Uring holds the mappings of an io_uring instance, set up with the raw syscalls
+ * so that liburing is not needed.
+ */
+typedef struct {
+    int fd;
+    unsigned entries;
+    unsigned to_submit;
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe* sqes;
+    struct io_uring_cqe* cqes;
+    void* sq_ptr;
+    size_t sq_len;
+    void* cq_ptr;
+    size_t cq_len;
+    size_t sqes_len;
+} Uring;
+
+typedef struct {
+    int fd;
+    uint64_t size;
+    uint64_t offset; // next byte to read, only touched by the calling thread
+    bool reading;    // a read is in flight, only touched by the calling thread
+    State state;
+    StateApx state_apx;
+    uint32_t last_output; // only touched by the owning worker
+} Ingest_File;
+
+typedef struct Ingest Ingest;
+
+typedef struct {
+    Ingest* ingest;
+    pthread_t thread;
+    Ingest_Queue queue;
+} Ingest_Worker;
+
+struct Ingest {
+    uint32_t n_files;
+    Ingest_File* files;
+    uint32_t wnd_size;
+    uint32_t k; // 0 selects the exact engine
+
+    uint32_t n_bufs;
+    uint32_t buf_size;
+    uint8_t* buffers;
+    uint32_t* free_bufs;
+    uint32_t n_free;
+    pthread_mutex_t free_lock;
+    pthread_cond_t free_cond;
+
+    uint32_t n_workers;
+    Ingest_Worker* workers;
+
+    bool use_uring;
+    Uring ring;
+    uint32_t n_readers;
+    pthread_t* readers;
+    Ingest_Queue requests;
+    Ingest_Queue completions;
+
+    uint64_t bytes;
+    uint64_t duration_nano;
+    uint64_t n_merges; // bucket merges of the approximate engine, over all workers
+    int error;
+};
+
+uint64_t ingest_queue_init(Ingest_Queue* q, uint32_t capacity) {
+    q->jobs = (Ingest_Job*) malloc(capacity * sizeof(Ingest_Job));
+    q->capacity = capacity;
+    q->head = 0;
+    q->count = 0;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    return capacity * sizeof(Ingest_Job);
+}
+
+void ingest_queue_destroy(Ingest_Queue* q) {
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->lock);
+    free(q->jobs);
+    q->jobs = NULL;
+}
+
+void ingest_queue_push(Ingest_Queue* q, Ingest_Job job) {
+    pthread_mutex_lock(&q->lock);
+    assert(q->count < q->capacity);
+    q->jobs[(q->head + q->count) % q->capacity] = job;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+}
+
+/*
+ * ingest_queue_pop removes the oldest job
+ * wait: whether to block until a job is available
+ * returns: false if the queue is empty and wait is false
+ */
+bool ingest_queue_pop(Ingest_Queue* q, Ingest_Job* job, bool wait) {
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0) {
+        if (!wait) {
+            pthread_mutex_unlock(&q->lock);
+            return false;
+        }
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+    *job = q->jobs[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    pthread_mutex_unlock(&q->lock);
+    return true;
+}
+
+/*
+ * uring_supports_read checks that the kernel knows IORING_OP_READ (Linux 5.6)
+ * fd: the io_uring instance
+ *
+ * Kernels 5.1 to 5.5 set up a ring but fail every such read with -EINVAL. They do not
+ * know IORING_REGISTER_PROBE either, so a failed probe also means the opcode is missing.
+ */
+bool uring_supports_read(int fd) {
+    size_t len = sizeof(struct io_uring_probe) + IORING_OP_LAST * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe* probe = (struct io_uring_probe*) calloc(1, len);
+    int ret = (int) syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST);
+    bool supported = ret >= 0 && probe->last_op >= IORING_OP_READ
+        && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+    free(probe);
+    return supported;
+}
+
+/*
+ * uring_init sets up an io_uring instance
+ * returns: 0 on success, -errno if io_uring (or its read opcode) is not available
+ */
+int uring_init(Uring* r, unsigned entries) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int) syscall(__NR_io_uring_setup, entries, &p);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (!uring_supports_read(fd)) {
+        close(fd);
+        return -EOPNOTSUPP;
+    }
+    r->fd = fd;
+    r->entries = p.sq_entries;
+    r->to_submit = 0;
+
+    r->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sq_ptr = mmap(NULL, r->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    r->cq_ptr = mmap(NULL, r->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    r->sqes = (struct io_uring_sqe*) mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r->sq_ptr == MAP_FAILED || r->cq_ptr == MAP_FAILED || (void*) r->sqes == MAP_FAILED) {
+        int err = errno;
+        if (r->sq_ptr != MAP_FAILED) munmap(r->sq_ptr, r->sq_len);
+        if (r->cq_ptr != MAP_FAILED) munmap(r->cq_ptr, r->cq_len);
+        if ((void*) r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_len);
+        close(fd);
+        return -err;
+    }
+
+    uint8_t* sq = (uint8_t*) r->sq_ptr;
+    r->sq_head = (unsigned*) (sq + p.sq_off.head);
+    r->sq_tail = (unsigned*) (sq + p.sq_off.tail);
+    r->sq_mask = (unsigned*) (sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned*) (sq + p.sq_off.array);
+    uint8_t* cq = (uint8_t*) r->cq_ptr;
+    r->cq_head = (unsigned*) (cq + p.cq_off.head);
+    r->cq_tail = (unsigned*) (cq + p.cq_off.tail);
+    r->cq_mask = (unsigned*) (cq + p.cq_off.ring_mask);
+    r->cqes = (struct io_uring_cqe*) (cq + p.cq_off.cqes);
+    return 0;
+}
+
+void uring_destroy(Uring* r) {
+    munmap(r->sqes, r->sqes_len);
+    munmap(r->cq_ptr, r->cq_len);
+    munmap(r->sq_ptr, r->sq_len);
+    close(r->fd);
+}
+
+/*
+ * uring_prep_read queues a read, it is sent to the kernel by the next uring_submit_and_wait.
+ * The caller never has more than r->entries reads in flight, so a slot is always free.
+ */
+void uring_prep_read(Uring* r, int fd, void* buf, uint32_t len, uint64_t offset, uint64_t user_data) {
+    unsigned tail = *r->sq_tail;
+    unsigned index = tail & *r->sq_mask;
+    struct io_uring_sqe* sqe = &r->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t) (uintptr_t) buf;
+    sqe->len = len;
+    sqe->off = offset;
+    sqe->user_data = user_data;
+    r->sq_array[index] = index;
+    __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    r->to_submit++;
+}
+
+/*
+ * uring_submit_and_wait submits the queued reads and waits for at least min_complete completions
+ * returns: 0 on success, -errno on failure
+ */
+int uring_submit_and_wait(Uring* r, unsigned min_complete) {
+    unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        int ret = (int) syscall(__NR_io_uring_enter, r->fd, r->to_submit, min_complete, flags, NULL, 0);
+        if (ret >= 0) {
+            r->to_submit -= ret;
+            if (r->to_submit == 0) {
+                return 0;
+            }
+        } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            return -errno;
+        }
+    }
+}
+
+/*
+ * uring_pop takes one completion off the completion queue
+ * returns: false if there is none
+ */
+bool uring_pop(Uring* r, uint64_t* user_data, int32_t* res) {
+    unsigned head = *r->cq_head;
+    unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+    struct io_uring_cqe* cqe = &r->cqes[head & *r->cq_mask];
+    *user_data = cqe->user_data;
+    *res = cqe->res;
+    __atomic_store_n(r->cq_head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ * ingest_acquire_buffer takes a buffer from the pool
+ * wait: whether to block until a buffer is returned by a worker
+ * returns: the index of the buffer, or UINT32_MAX if none is free and wait is false
+ */
+uint32_t ingest_acquire_buffer(Ingest* self, bool wait) {
+    pthread_mutex_lock(&self->free_lock);
+    while (self->n_free == 0) {
+        if (!wait) {
+            pthread_mutex_unlock(&self->free_lock);
+            return UINT32_MAX;
+        }
+        pthread_cond_wait(&self->free_cond, &self->free_lock);
+    }
+    self->n_free--;
+    uint32_t buf = self->free_bufs[self->n_free];
+    pthread_mutex_unlock(&self->free_lock);
+    return buf;
+}
+
+void ingest_release_buffer(Ingest* self, uint32_t buf) {
+    pthread_mutex_lock(&self->free_lock);
+    self->free_bufs[self->n_free] = buf;
+    self->n_free++;
+    pthread_cond_signal(&self->free_cond);
+    pthread_mutex_unlock(&self->free_lock);
+}
+
+void* ingest_worker_main(void* arg) {
+    Ingest_Worker* worker = (Ingest_Worker*) arg;
+    Ingest* self = worker->ingest;
+    Ingest_Job job;
+    for (;;) {
+        ingest_queue_pop(&worker->queue, &job, true);
+        if (job.file == INGEST_STOP) {
+            __atomic_fetch_add(&self->n_merges, N_MERGES, __ATOMIC_RELAXED);
+            break;
+        }
+        Ingest_File* file = &self->files[job.file];
+        const uint8_t* bits = self->buffers + (uint64_t) job.buf * self->buf_size;
+        uint64_t n_items = ((uint64_t) job.n_bytes) * 8;
+        if (self->k == 0) {
+            file->last_output = wnd_bit_count_next_batch(&file->state, bits, n_items);
+        } else {
+            file->last_output = wnd_bit_count_apx_next_batch(&file->state_apx, bits, n_items);
+        }
+        ingest_release_buffer(self, job.buf);
+    }
+    return NULL;
+}
+
+void* ingest_reader_main(void* arg) {
+    Ingest* self = (Ingest*) arg;
+    Ingest_Job job;
+    for (;;) {
+        ingest_queue_pop(&self->requests, &job, true);
+        if (job.file == INGEST_STOP) {
+            break;
+        }
+        uint8_t* buf = self->buffers + (uint64_t) job.buf * self->buf_size;
+        ssize_t n = pread(self->files[job.file].fd, buf, job.n_bytes, job.offset);
+        job.n_bytes = n < 0 ? -errno : n;
+        ingest_queue_push(&self->completions, job);
+    }
+    return NULL;
+}
+
+/*
+ * ingest_new opens the trace files and allocates the pipeline
+ * paths: the trace files, one window per file
+ * k: 0 for the exact engine, otherwise k = 1/eps of the approximate engine
+ * n_workers: the number of threads running the engines
+ * n_bufs, buf_size: the buffer pool, buf_size must be a multiple of 8
+ * use_uring: issue reads through io_uring, falls back to reader threads if it is not available
+ * returns: the total number of bytes allocated on the heap
+ */
+uint64_t ingest_new(Ingest* self, const char** paths, uint32_t n_files, uint32_t wnd_size, uint32_t k,
+                    uint32_t n_workers, uint32_t n_bufs, uint32_t buf_size, bool use_uring) {
+    assert(n_files >= 1);
+    assert(n_workers >= 1);
+    assert(n_bufs >= 1);
+    assert(buf_size >= 8 && buf_size % 8 == 0);
+
+    uint64_t memory = 0;
+
+    self->n_files = n_files;
+    self->wnd_size = wnd_size;
+    self->k = k;
+    self->files = (Ingest_File*) malloc(n_files * sizeof(Ingest_File));
+    memory += n_files * sizeof(Ingest_File);
+    for (uint32_t i = 0; i < n_files; i++) {
+        Ingest_File* file = &self->files[i];
+        file->fd = open(paths[i], O_RDONLY);
+        if (file->fd < 0) {
+            printf("%s could not be opened.\n", paths[i]);
+            exit(1);
+        }
+        struct stat st;
+        fstat(file->fd, &st);
+        file->size = st.st_size;
+        file->offset = 0;
+        file->reading = false;
+        file->last_output = 0;
+        if (k == 0) {
+            memory += wnd_bit_count_new(&file->state, wnd_size);
+        } else {
+            memory += wnd_bit_count_apx_new(&file->state_apx, wnd_size, k);
+        }
+    }
+
+    self->n_bufs = n_bufs;
+    self->buf_size = buf_size;
+    self->buffers = (uint8_t*) malloc((uint64_t) n_bufs * buf_size);
+    self->free_bufs = (uint32_t*) malloc(n_bufs * sizeof(uint32_t));
+    memory += (uint64_t) n_bufs * buf_size + n_bufs * sizeof(uint32_t);
+    for (uint32_t i = 0; i < n_bufs; i++) {
+        self->free_bufs[i] = n_bufs - 1 - i;
+    }
+    self->n_free = n_bufs;
+    pthread_mutex_init(&self->free_lock, NULL);
+    pthread_cond_init(&self->free_cond, NULL);
+
+    self->n_workers = n_workers;
+    self->workers = (Ingest_Worker*) malloc(n_workers * sizeof(Ingest_Worker));
+    memory += n_workers * sizeof(Ingest_Worker);
+    for (uint32_t i = 0; i < n_workers; i++) {
+        self->workers[i].ingest = self;
+        memory += ingest_queue_init(&self->workers[i].queue, n_bufs + 1);
+    }
+
+    self->use_uring = false;
+    if (use_uring) {
+        int err = uring_init(&self->ring, INGEST_QUEUE_DEPTH);
+        if (err == 0) {
+            self->use_uring = true;
+        } else {
+            printf("io_uring is not available (%s), using reader threads\n", strerror(-err));
+        }
+    }
+    self->n_readers = 0;
+    self->readers = NULL;
+    if (!self->use_uring) {
+        self->n_readers = n_bufs < INGEST_QUEUE_DEPTH ? n_bufs : INGEST_QUEUE_DEPTH;
+        self->readers = (pthread_t*) malloc(self->n_readers * sizeof(pthread_t));
+        memory += self->n_readers * sizeof(pthread_t);
+        memory += ingest_queue_init(&self->requests, n_bufs + self->n_readers);
+        memory += ingest_queue_init(&self->completions, n_bufs);
+    }
+
+    self->bytes = 0;
+    self->duration_nano = 0;
+    self->n_merges = 0;
+    self->error = 0;
+
+    return memory;
+}
+
+void ingest_destruct(Ingest* self) {
+    for (uint32_t i = 0; i < self->n_files; i++) {
+        Ingest_File* file = &self->files[i];
+        close(file->fd);
+        if (self->k == 0) {
+            wnd_bit_count_destruct(&file->state);
+        } else {
+            wnd_bit_count_apx_destruct(&file->state_apx);
+        }
+    }
+    free(self->files);
+
+    for (uint32_t i = 0; i < self->n_workers; i++) {
+        ingest_queue_destroy(&self->workers[i].queue);
+    }
+    free(self->workers);
+
+    if (self->use_uring) {
+        uring_destroy(&self->ring);
+    } else {
+        ingest_queue_destroy(&self->requests);
+        ingest_queue_destroy(&self->completions);
+        free(self->readers);
+    }
+
+    pthread_cond_destroy(&self->free_cond);
+    pthread_mutex_destroy(&self->free_lock);
+    free(self->free_bufs);
+    free(self->buffers);
+}
+
+/*
+ * ingest_complete_read handles a finished read: the buffer goes to the worker owning
+ * the file, or back to the pool if nothing was read
+ * returns: whether the file is finished
+ */
+bool ingest_complete_read(Ingest* self, uint32_t f, uint32_t buf, int64_t n_bytes) {
+    Ingest_File* file = &self->files[f];
+    file->reading = false;
+    if (n_bytes <= 0) {
+        if (n_bytes < 0) {
+            printf("read failed (%s)\n", strerror((int) -n_bytes));
+            self->error = -1;
+        }
+        // the file is shorter than it was at open time, stop reading it
+        ingest_release_buffer(self, buf);
+        file->offset = file->size;
+        return true;
+    }
+
+    file->offset += n_bytes;
+    self->bytes += n_bytes;
+    Ingest_Job job = {f, buf, 0, n_bytes};
+    ingest_queue_push(&self->workers[f % self->n_workers].queue, job);
+    return file->offset >= file->size;
+}
+
+/*
+ * ingest_run reads all the files to the end and feeds them to their windows.
+ * The outputs are available through ingest_output afterwards.
+ * returns: 0 on success, -1 if a read failed
+ */
+int ingest_run(Ingest* self) {
+    struct timespec tick, tock;
+    clock_gettime(CLOCK_MONOTONIC, &tick);
+
+    for (uint32_t i = 0; i < self->n_workers; i++) {
+        pthread_create(&self->workers[i].thread, NULL, ingest_worker_main, &self->workers[i]);
+    }
+    for (uint32_t i = 0; i < self->n_readers; i++) {
+        pthread_create(&self->readers[i], NULL, ingest_reader_main, self);
+    }
+
+    uint32_t max_inflight = self->use_uring ? self->ring.entries : self->n_readers;
+    uint32_t n_done = 0;
+    for (uint32_t i = 0; i < self->n_files; i++) {
+        n_done += self->files[i].size == 0;
+    }
+    uint32_t inflight = 0;
+    uint32_t next_file = 0;
+
+    while (n_done < self->n_files) {
+        // issue a read for every idle file while there are free buffers
+        for (uint32_t scanned = 0; scanned < self->n_files && inflight < max_inflight; scanned++) {
+            uint32_t f = next_file;
+            next_file = (next_file + 1) % self->n_files;
+            Ingest_File* file = &self->files[f];
+            if (file->reading || file->offset >= file->size) {
+                continue;
+            }
+            uint32_t buf = ingest_acquire_buffer(self, false);
+            if (buf == UINT32_MAX) {
+                break;
+            }
+            uint64_t left = file->size - file->offset;
+            uint32_t len = left < self->buf_size ? (uint32_t) left : self->buf_size;
+            uint8_t* dst = self->buffers + (uint64_t) buf * self->buf_size;
+            if (self->use_uring) {
+                uring_prep_read(&self->ring, file->fd, dst, len, file->offset, ((uint64_t) f << 32) | buf);
+            } else {
+                Ingest_Job job = {f, buf, file->offset, len};
+                ingest_queue_push(&self->requests, job);
+            }
+            file->reading = true;
+            inflight++;
+        }
+
+        if (inflight == 0) {
+            // every buffer is with the workers
+            uint32_t buf = ingest_acquire_buffer(self, true);
+            ingest_release_buffer(self, buf);
+            continue;
+        }
+
+        if (self->use_uring) {
+            int err = uring_submit_and_wait(&self->ring, 1);
+            if (err < 0) {
+                printf("io_uring_enter failed (%s)\n", strerror(-err));
+                exit(1);
+            }
+            uint64_t user_data;
+            int32_t res;
+            while (uring_pop(&self->ring, &user_data, &res)) {
+                inflight--;
+                n_done += ingest_complete_read(self, (uint32_t) (user_data >> 32), (uint32_t) user_data, res);
+            }
+        } else {
+            Ingest_Job job;
+            bool wait = true;
+            while (ingest_queue_pop(&self->completions, &job, wait)) {
+                inflight--;
+                n_done += ingest_complete_read(self, job.file, job.buf, job.n_bytes);
+                wait = false;
+            }
+        }
+    }
+
+    Ingest_Job stop = {INGEST_STOP, 0, 0, 0};
+    for (uint32_t i = 0; i < self->n_readers; i++) {
+        ingest_queue_push(&self->requests, stop);
+    }
+    for (uint32_t i = 0; i < self->n_readers; i++) {
+        pthread_join(self->readers[i], NULL);
+    }
+    for (uint32_t i = 0; i < self->n_workers; i++) {
+        ingest_queue_push(&self->workers[i].queue, stop);
+    }
+    for (uint32_t i = 0; i < self->n_workers; i++) {
+        pthread_join(self->workers[i].thread, NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &tock);
+    self->duration_nano = 1000000000L * (tock.tv_sec - tick.tv_sec) + tock.tv_nsec - tick.tv_nsec;
+
+    return self->error;
+}
+
+/*
+ * ingest_output returns the count of the bits in the window of a file after ingest_run
+ */
+uint32_t ingest_output(Ingest* self, uint32_t file) {
+    return self->files[file].last_output;
+}
+
+#endif // _WINDOW_BIT_COUNT_INGEST_
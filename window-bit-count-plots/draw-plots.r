@@ -4,7 +4,8 @@ library("dplyr")
 
 df <-
   read.table("results.txt",
-             col.names=c("algo", "wnd_sz", "throughput", "memory"),
+             col.names=c("algo", "wnd_sz", "throughput", "memory",
+                         "cycles", "instructions", "llc_misses", "branch_misses", "dtlb_misses"),
              skip=0, header=FALSE, sep=" ")
 head(df)
 
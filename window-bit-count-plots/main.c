@@ -1,10 +1,12 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdint.h>
+#include <string.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "../utils.h"
+#include "../perf-counters.h"
 #include "../window-bit-count/window-bit-count.h"
 #include "../window-bit-count-apx/window-bit-count-apx.h"
 
@@ -18,6 +20,7 @@ typedef struct {
 	uint32_t wnd_sz;
 	uint64_t throughput;
 	uint64_t memory;
+	double perf[PERF_NUM_EVENTS]; // hardware counters per item, NAN when not available
 } Record;
 
 const uint32_t N = 150*1000*1000L; // stream length
@@ -32,7 +35,14 @@ const uint32_t K_OPTIONS[NUM_K] = {
 uint32_t r_index = 0;
 Record results[T*NUM_W*(1+NUM_K)];
 
-void execute(uint32_t wnd_sz) {
+// the states are allocated in the first trial and reset in the following ones
+State states[NUM_W];
+StateApx states_apx[NUM_W][NUM_K];
+uint64_t memory_exact[NUM_W];
+uint64_t memory_apx[NUM_W][NUM_K];
+
+void execute(uint32_t w_index, uint32_t trial) {
+    uint32_t wnd_sz = W_OPTIONS[w_index];
     char scratch[100];
 
     printf("**** BENCHMARK: Bit counting over a sliding window *****\n");
@@ -43,19 +53,34 @@ void execute(uint32_t wnd_sz) {
     u64_to_str_with_sep(wnd_sz, ',', scratch);
     printf("window size = %s\n", scratch);
 
-    State state;
-    uint64_t memory = wnd_bit_count_new(&state, wnd_sz);
+    State* state = &states[w_index];
+    if (trial == 0) {
+        memory_exact[w_index] = wnd_bit_count_new(state, wnd_sz);
+    } else {
+        wnd_bit_count_reset(state);
+    }
+    uint64_t memory = memory_exact[w_index];
+    // new and reset leave the pages of a large window to be faulted in and zeroed on first
+    // touch, do that here so that the timed loop only measures the stream
+    memset(state->wnd_buffer, 0, wnd_sz);
+
+    Perf_Counters counters;
+    perf_counters_open(&counters);
 
     struct timespec tick, tock;
 	clock_gettime(CLOCK_MONOTONIC, &tick);
+    perf_counters_start(&counters);
 
     uint32_t last_output = 0;
     for (uint32_t i=1; i<=N; i++) {
         bool item = true; //i % 2;
-        last_output = wnd_bit_count_next(&state, item);
+        last_output = wnd_bit_count_next(state, item);
     }
 
+    perf_counters_stop(&counters);
     clock_gettime(CLOCK_MONOTONIC, &tock);
+    perf_counters_read(&counters);
+    perf_counters_close(&counters);
 
     u64_to_str_with_sep(last_output, ',', scratch);
     printf("last output = %s\n", scratch);
@@ -71,18 +96,22 @@ void execute(uint32_t wnd_sz) {
     u64_to_str_with_sep(memory, ',', scratch);
     printf("memory footprint = %s bytes\n", scratch);
 
-    printf("\n");
+    perf_counters_print(&counters, N);
 
-    wnd_bit_count_destruct(&state);
+    printf("\n");
 
 	results[r_index].algo = 0;
 	results[r_index].wnd_sz = wnd_sz;
 	results[r_index].throughput = throughput;
 	results[r_index].memory = memory;
+    for (uint32_t e=0; e<PERF_NUM_EVENTS; e++) {
+        results[r_index].perf[e] = counters.values[e] / N;
+    }
     r_index += 1;
 }
 
-void execute_apx(uint32_t wnd_sz, uint32_t k_index) {
+void execute_apx(uint32_t w_index, uint32_t k_index, uint32_t trial) {
+    uint32_t wnd_sz = W_OPTIONS[w_index];
     char scratch[100];
 
     printf("**** BENCHMARK: Bit counting over a sliding window (approximate) *****\n");
@@ -99,19 +128,33 @@ void execute_apx(uint32_t wnd_sz, uint32_t k_index) {
     u64_to_str_with_sep(k, ',', scratch);
     printf("k = %s\n", scratch);
 
-    StateApx state;
-    uint64_t memory = wnd_bit_count_apx_new(&state, wnd_sz, k);
+    StateApx* state = &states_apx[w_index][k_index];
+    if (trial == 0) {
+        memory_apx[w_index][k_index] = wnd_bit_count_apx_new(state, wnd_sz, k);
+    } else {
+        wnd_bit_count_apx_reset(state);
+    }
+    uint64_t memory = memory_apx[w_index][k_index];
+    // fault the memory pool in before the timed loop as well, all its buckets are unused here
+    memset(state->pool->bucket_pool, 0, state->pool->size * sizeof(Bucket));
+
+    Perf_Counters counters;
+    perf_counters_open(&counters);
 
     struct timespec tick, tock;
 	clock_gettime(CLOCK_MONOTONIC, &tick);
+    perf_counters_start(&counters);
 
     uint32_t last_output = 0;
     for (uint32_t i=1; i<=N; i++) {
         bool item = true; //i % 2;
-        last_output = wnd_bit_count_apx_next(&state, item);
+        last_output = wnd_bit_count_apx_next(state, item);
     }
 
+    perf_counters_stop(&counters);
     clock_gettime(CLOCK_MONOTONIC, &tock);
+    perf_counters_read(&counters);
+    perf_counters_close(&counters);
 
     u64_to_str_with_sep(last_output, ',', scratch);
     printf("last output = %s\n", scratch);
@@ -130,14 +173,17 @@ void execute_apx(uint32_t wnd_sz, uint32_t k_index) {
     u64_to_str_with_sep(memory, ',', scratch);
     printf("memory footprint = %s bytes\n", scratch);
 
-    printf("\n");
+    perf_counters_print(&counters, N);
 
-    wnd_bit_count_apx_destruct(&state);
+    printf("\n");
 
 	results[r_index].algo = k_index + 1;
 	results[r_index].wnd_sz = wnd_sz;
 	results[r_index].throughput = throughput;
 	results[r_index].memory = memory;
+    for (uint32_t e=0; e<PERF_NUM_EVENTS; e++) {
+        results[r_index].perf[e] = counters.values[e] / N;
+    }
     r_index += 1;
 }
 
@@ -152,16 +198,22 @@ int main() {
 
 	for (uint32_t i=0; i<T; i++) {
 		for (uint32_t j=0; j<NUM_W; j++) {
-			uint32_t wnd_sz = W_OPTIONS[j];
-            execute(wnd_sz);
+            execute(j, i);
             sleep(P);
             for (uint32_t k=0; k<NUM_K; k++) {
-                execute_apx(wnd_sz, k);
+                execute_apx(j, k, i);
                 sleep(P);
             }
 		}
 	} // trial loop
 
+    for (uint32_t j=0; j<NUM_W; j++) {
+        wnd_bit_count_destruct(&states[j]);
+        for (uint32_t k=0; k<NUM_K; k++) {
+            wnd_bit_count_apx_destruct(&states_apx[j][k]);
+        }
+    }
+
 	time_t now;
 	time(&now);
 	struct tm *local = localtime(&now);
@@ -195,9 +247,13 @@ int main() {
         } else {
             sprintf(scratch, "apx[k=%u]", K_OPTIONS[r.algo-1]);
         }
-        char scratch2[200];
-        sprintf(scratch2, "%s %u %lu %lu",
+        char scratch2[300];
+        int c = sprintf(scratch2, "%s %u %lu %lu",
             scratch, r.wnd_sz, r.throughput, r.memory);
+        for (uint32_t e=0; e<PERF_NUM_EVENTS; e++) {
+            scratch2[c] = ' ';
+            c += 1 + perf_value_to_str(r.perf[e], 1, scratch2 + c + 1);
+        }
         printf("%s\n", scratch2);
         fprintf(stream1, "%s\n", scratch2);
         fprintf(stream2, "%s\n", scratch2);
@@ -0,0 +1,92 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils.h"
+#include "../window-bit-count/window-bit-count.h"
+#include "../window-bit-count-apx/window-bit-count-apx.h"
+
+#define NUM_W 8
+#define K 100 // relative error = 1 / K
+
+const uint32_t W_OPTIONS[NUM_W] = { // window sizes
+	10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+uint64_t elapsed_nano(struct timespec tick, struct timespec tock) {
+    return 1000000000L * (tock.tv_sec - tick.tv_sec) + tock.tv_nsec - tick.tv_nsec;
+}
+
+/*
+ * fill runs a full window of 1s through the states, so that reset has live state to clear
+ */
+void fill(State* state, StateApx* state_apx, uint32_t wnd_sz) {
+    for (uint32_t i=1; i<=wnd_sz; i++) {
+        wnd_bit_count_next(state, true);
+        wnd_bit_count_apx_next(state_apx, true);
+    }
+}
+
+int main() {
+    char scratch[100];
+    char scratch2[100];
+
+    printf("**** BENCHMARK: Time to first item *****\n");
+
+    u64_to_str_with_sep(K, ',', scratch);
+    printf("k = %s\n", scratch);
+
+    printf("\n");
+    printf("%14s %16s %16s %16s %16s\n", "window size", "exact new", "exact reset", "apx new", "apx reset");
+
+    for (uint32_t j=0; j<NUM_W; j++) {
+        uint32_t wnd_sz = W_OPTIONS[j];
+        State state;
+        StateApx state_apx;
+        struct timespec tick, tock;
+        uint64_t exact_new, exact_reset, apx_new, apx_reset;
+
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        wnd_bit_count_new(&state, wnd_sz);
+        wnd_bit_count_next(&state, true);
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        exact_new = elapsed_nano(tick, tock);
+
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        wnd_bit_count_apx_new(&state_apx, wnd_sz, K);
+        wnd_bit_count_apx_next(&state_apx, true);
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        apx_new = elapsed_nano(tick, tock);
+
+        fill(&state, &state_apx, wnd_sz);
+
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        wnd_bit_count_reset(&state);
+        wnd_bit_count_next(&state, true);
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        exact_reset = elapsed_nano(tick, tock);
+
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        wnd_bit_count_apx_reset(&state_apx);
+        wnd_bit_count_apx_next(&state_apx, true);
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        apx_reset = elapsed_nano(tick, tock);
+
+        wnd_bit_count_apx_destruct(&state_apx);
+        wnd_bit_count_destruct(&state);
+
+        u64_to_str_with_sep(wnd_sz, ',', scratch);
+        printf("%14s", scratch);
+        u64_to_str_with_sep(exact_new, ',', scratch2);
+        printf(" %13s ns", scratch2);
+        u64_to_str_with_sep(exact_reset, ',', scratch2);
+        printf(" %13s ns", scratch2);
+        u64_to_str_with_sep(apx_new, ',', scratch2);
+        printf(" %13s ns", scratch2);
+        u64_to_str_with_sep(apx_reset, ',', scratch2);
+        printf(" %13s ns\n", scratch2);
+    }
+
+    return 0;
+}
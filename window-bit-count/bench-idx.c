@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils.h"
+#include "window-bit-count.h"
+
+#define W 1000000 // window size
+#define Q 20000000 // number of range queries on the index
+#define Q_SCAN 2000 // number of range queries answered by scanning the exact window
+
+uint64_t x = RANDOM_SEED;
+
+/*
+ * random_range picks a random interval [from, to) inside the window
+ */
+void random_range(uint32_t* from, uint32_t* to) {
+    uint64_t r = next_random(&x);
+    uint32_t a = (r & 0xffffffff) % (W + 1);
+    uint32_t b = (r >> 32) % (W + 1);
+    *from = a < b ? a : b;
+    *to = a < b ? b : a;
+}
+
+void print_result(uint64_t n_queries, uint64_t checksum, struct timespec tick, struct timespec tock, uint64_t memory) {
+    char scratch[100];
+
+    u64_to_str_with_sep(checksum, ',', scratch);
+    printf("sum of outputs = %s\n", scratch);
+
+	uint64_t duration_nano = 1000000000L * (tock.tv_sec - tick.tv_sec) + tock.tv_nsec - tick.tv_nsec;
+    u64_to_str_with_sep(duration_nano, ',', scratch);
+	printf("duration = %s nanoseconds\n", scratch);
+
+	uint64_t throughput = (1000000000L * n_queries) / duration_nano;
+    u64_to_str_with_sep(throughput, ',', scratch);
+	printf("throughput = %s queries/sec\n", scratch);
+
+    u64_to_str_with_sep(memory, ',', scratch);
+    printf("memory footprint = %s bytes\n", scratch);
+
+    printf("\n");
+}
+
+int main() {
+    char scratch[100];
+
+    printf("**** BENCHMARK: Range queries over a sliding window *****\n");
+
+    u64_to_str_with_sep(W, ',', scratch);
+    printf("window size = %s\n", scratch);
+
+    printf("\n");
+
+    State state;
+    StateIdx state_idx;
+    uint64_t memory = wnd_bit_count_new(&state, W);
+    uint64_t memory_idx = wnd_bit_count_idx_new(&state_idx, W);
+
+    for (uint32_t i=1; i<=3*W/2; i++) {
+        bool item = next_random(&x) & 1;
+        wnd_bit_count_next(&state, item);
+        wnd_bit_count_idx_next(&state_idx, item);
+    }
+
+    struct timespec tick, tock;
+    uint32_t from, to;
+    uint64_t checksum;
+
+    printf("---- indexed window -----\n");
+    u64_to_str_with_sep(Q, ',', scratch);
+    printf("queries = %s\n", scratch);
+
+    checksum = 0;
+	clock_gettime(CLOCK_MONOTONIC, &tick);
+    for (uint32_t i=1; i<=Q; i++) {
+        random_range(&from, &to);
+        checksum += wnd_bit_count_idx_range(&state_idx, from, to);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &tock);
+    print_result(Q, checksum, tick, tock, memory_idx);
+
+    printf("---- exact window, scanning the ring -----\n");
+    u64_to_str_with_sep(Q_SCAN, ',', scratch);
+    printf("queries = %s\n", scratch);
+
+    checksum = 0;
+	clock_gettime(CLOCK_MONOTONIC, &tick);
+    for (uint32_t i=1; i<=Q_SCAN; i++) {
+        random_range(&from, &to);
+        for (uint32_t age=from; age<to; age++) {
+            checksum += state.wnd_buffer[(state.index_oldest + 2 * W - 1 - age) % W];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &tock);
+    print_result(Q_SCAN, checksum, tick, tock, memory);
+
+    wnd_bit_count_idx_destruct(&state_idx);
+    wnd_bit_count_destruct(&state);
+
+    return 0;
+}
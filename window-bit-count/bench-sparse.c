@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <math.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../utils.h"
+#include "window-bit-count.h"
+
+#define W 1000000 // window size
+#define N 100000000 // stream length
+#define NUM_P 5
+
+const double P_OPTIONS[NUM_P] = { // density of ones
+    0.5, 0.1, 0.01, 0.001, 0.0001
+};
+
+uint64_t x = RANDOM_SEED;
+
+/*
+ * next_item draws an item that is 1 with probability p, encoded as p * 2^53
+ */
+bool next_item(uint64_t threshold) {
+    return (next_random(&x) >> 11) < threshold;
+}
+
+void print_result(uint32_t last_output, struct timespec tick, struct timespec tock, uint64_t memory, uint64_t peak_memory) {
+    char scratch[100];
+
+    u64_to_str_with_sep(last_output, ',', scratch);
+    printf("last output = %s\n", scratch);
+
+	uint64_t duration_nano = 1000000000L * (tock.tv_sec - tick.tv_sec) + tock.tv_nsec - tick.tv_nsec;
+    u64_to_str_with_sep(duration_nano, ',', scratch);
+	printf("duration = %s nanoseconds\n", scratch);
+
+	uint64_t throughput = (1000000000L * N) / duration_nano;
+    u64_to_str_with_sep(throughput, ',', scratch);
+	printf("throughput = %s items/sec\n", scratch);
+
+    u64_to_str_with_sep(memory, ',', scratch);
+    printf("memory footprint = %s bytes\n", scratch);
+
+    u64_to_str_with_sep(peak_memory, ',', scratch);
+    printf("peak memory footprint = %s bytes\n", scratch);
+
+    printf("\n");
+}
+
+int main() {
+    char scratch[100];
+
+    printf("**** BENCHMARK: Bit counting over a sliding window (dense vs sparse) *****\n");
+
+    u64_to_str_with_sep(N, ',', scratch);
+    printf("stream length = %s\n", scratch);
+
+    u64_to_str_with_sep(W, ',', scratch);
+    printf("window size = %s\n", scratch);
+
+    printf("\n");
+
+    for (uint32_t j=0; j<NUM_P; j++) {
+        uint64_t threshold = (uint64_t) (P_OPTIONS[j] * (1ULL << 53));
+        struct timespec tick, tock;
+        uint32_t last_output;
+
+        printf("---- dense, p = %g -----\n", P_OPTIONS[j]);
+        State state;
+        uint64_t memory = wnd_bit_count_new(&state, W);
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        last_output = 0;
+        for (uint32_t i=1; i<=N; i++) {
+            last_output = wnd_bit_count_next(&state, next_item(threshold));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        print_result(last_output, tick, tock, memory, memory);
+        wnd_bit_count_destruct(&state);
+
+        printf("---- sparse, p = %g -----\n", P_OPTIONS[j]);
+        StateSparse state_sparse;
+        wnd_bit_count_sparse_new(&state_sparse, W);
+        clock_gettime(CLOCK_MONOTONIC, &tick);
+        last_output = 0;
+        for (uint32_t i=1; i<=N; i++) {
+            last_output = wnd_bit_count_sparse_next(&state_sparse, next_item(threshold));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &tock);
+        print_result(last_output, tick, tock, wnd_bit_count_sparse_memory(&state_sparse),
+            wnd_bit_count_sparse_peak_memory(&state_sparse));
+        wnd_bit_count_sparse_destruct(&state_sparse);
+    }
+
+    return 0;
+}
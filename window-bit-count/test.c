@@ -1,11 +1,174 @@
 #include <stdio.h>
 #include <math.h>
 #include <stdint.h>
+#include <assert.h>
+
+#include "../utils.h"
 #include "window-bit-count.h"
 
 #define W 10 // window size
 #define N 100 // stream length
 
+/*
+ * count_range_scan counts the ones with age in [from, to) by scanning the ring of the exact window
+ */
+uint32_t count_range_scan(State* state, uint32_t from, uint32_t to) {
+    uint32_t count = 0;
+    for (uint32_t age=from; age<to; age++) {
+        uint32_t index = (state->index_oldest + 2 * state->wnd_size - 1 - age) % state->wnd_size;
+        count += state->wnd_buffer[index];
+    }
+    return count;
+}
+
+void test_idx() {
+    printf("**** TEST: Bit counting over a sliding window (indexed) *****\n");
+
+    uint32_t wnd_sizes[7] = {1, 7, 64, 511, 512, 513, 2000};
+    uint64_t x = RANDOM_SEED;
+
+    for (uint32_t j=0; j<7; j++) {
+        uint32_t wnd_sz = wnd_sizes[j];
+        State state;
+        StateIdx state_idx;
+        wnd_bit_count_new(&state, wnd_sz);
+        wnd_bit_count_idx_new(&state_idx, wnd_sz);
+
+        for (uint32_t i=1; i<=5*wnd_sz+3*IDX_BLOCK_BITS; i++) {
+            uint64_t r = next_random(&x);
+            bool item = (r % 3) == 0;
+            uint32_t last_output = wnd_bit_count_next(&state, item);
+            uint32_t last_output_idx = wnd_bit_count_idx_next(&state_idx, item);
+            assert(last_output == last_output_idx);
+
+            uint32_t from = (r >> 20) % (wnd_sz + 1);
+            uint32_t to = (r >> 40) % (wnd_sz + 1);
+            if (from > to) {
+                uint32_t tmp = from;
+                from = to;
+                to = tmp;
+            }
+            assert(wnd_bit_count_idx_range(&state_idx, from, to) == count_range_scan(&state, from, to));
+            assert(wnd_bit_count_idx_last(&state_idx, to) == count_range_scan(&state, 0, to));
+        }
+        wnd_bit_count_idx_print(&state_idx);
+
+        wnd_bit_count_idx_destruct(&state_idx);
+        wnd_bit_count_destruct(&state);
+    }
+}
+
+/*
+ * test_runs checks that feeding runs of equal items gives the same counts as single items
+ */
+void test_runs() {
+    printf("**** TEST: Bit counting over a sliding window (runs) *****\n");
+
+    uint32_t wnd_sizes[4] = {1, 7, 100, 1000};
+    uint64_t x = RANDOM_SEED;
+
+    for (uint32_t j=0; j<4; j++) {
+        uint32_t wnd_sz = wnd_sizes[j];
+        State state;
+        State state_run;
+        wnd_bit_count_new(&state, wnd_sz);
+        wnd_bit_count_new(&state_run, wnd_sz);
+
+        uint32_t last_output = 0;
+        for (uint32_t i=1; i<=N; i++) {
+            bool item = i % 2;
+            uint64_t run_length = (next_random(&x) >> 11) % (3 * wnd_sz);
+            for (uint64_t r=0; r<run_length; r++) {
+                last_output = wnd_bit_count_next(&state, item);
+            }
+            assert(wnd_bit_count_next_run(&state_run, item, run_length) == last_output);
+        }
+        printf("W = %u: last output = %u\n", wnd_sz, last_output);
+
+        wnd_bit_count_destruct(&state_run);
+        wnd_bit_count_destruct(&state);
+    }
+}
+
+/*
+ * test_reset checks that a window that was reset counts like a new one
+ */
+void test_reset() {
+    printf("**** TEST: Bit counting over a sliding window (reset) *****\n");
+
+    // the larger window is mapped from the kernel rather than allocated on the heap
+    uint32_t wnd_sizes[2] = {1000, 3 * WND_MMAP_THRESHOLD};
+
+    for (uint32_t j=0; j<2; j++) {
+        uint32_t wnd_sz = wnd_sizes[j];
+        State state;
+        State state_reset;
+        StateIdx state_idx;
+        wnd_bit_count_new(&state_reset, wnd_sz);
+        wnd_bit_count_idx_new(&state_idx, wnd_sz);
+        for (uint32_t i=1; i<=wnd_sz + 10; i++) {
+            wnd_bit_count_next(&state_reset, true);
+            wnd_bit_count_idx_next(&state_idx, true);
+        }
+        wnd_bit_count_reset(&state_reset);
+        wnd_bit_count_idx_reset(&state_idx);
+        wnd_bit_count_new(&state, wnd_sz);
+
+        uint64_t x = RANDOM_SEED;
+        uint32_t last_output = 0;
+        for (uint32_t i=1; i<=2 * wnd_sz; i++) {
+            bool item = next_random(&x) & 1;
+            last_output = wnd_bit_count_next(&state, item);
+            assert(wnd_bit_count_next(&state_reset, item) == last_output);
+            assert(wnd_bit_count_idx_next(&state_idx, item) == last_output);
+        }
+        printf("W = %u: last output = %u\n", wnd_sz, last_output);
+
+        wnd_bit_count_destruct(&state);
+        wnd_bit_count_idx_destruct(&state_idx);
+        wnd_bit_count_destruct(&state_reset);
+    }
+}
+
+/*
+ * test_sparse checks the window that stores the positions of the ones against the dense one
+ */
+void test_sparse() {
+    printf("**** TEST: Bit counting over a sliding window (sparse) *****\n");
+
+    uint32_t wnd_sizes[4] = {1, 10, 100, 5000};
+    uint32_t densities[4] = {1, 30, 500, 1000}; // ones per 1000 items
+    uint64_t x = RANDOM_SEED;
+
+    for (uint32_t a=0; a<4; a++) {
+        for (uint32_t b=0; b<4; b++) {
+            State state;
+            StateSparse state_sparse;
+            wnd_bit_count_new(&state, wnd_sizes[a]);
+            wnd_bit_count_sparse_new(&state_sparse, wnd_sizes[a]);
+            // start close to the end of the 32-bit timestamps, so that they wrap around
+            state_sparse.time = UINT32_MAX - 2 * wnd_sizes[a];
+
+            uint32_t last_output = 0;
+            for (uint32_t i=1; i<=4*wnd_sizes[a]+1000; i++) {
+                // a burst of ones in the middle makes the ring grow and shrink again
+                bool item = (next_random(&x) >> 20) % 1000 < densities[b] || (i > wnd_sizes[a] && i < 2 * wnd_sizes[a]);
+                last_output = wnd_bit_count_next(&state, item);
+                assert(wnd_bit_count_sparse_next(&state_sparse, item) == last_output);
+                assert(state_sparse.capacity == SPARSE_MIN_CAPACITY || state_sparse.count >= state_sparse.capacity / 4);
+            }
+            // the burst filled the window, so the ring held all of it at some point
+            assert(state_sparse.peak_capacity >= wnd_sizes[a] - 1);
+            printf("W = %u, density = %u/1000: last output = %u, memory = %lu bytes, peak memory = %lu bytes\n",
+                wnd_sizes[a], densities[b], last_output, wnd_bit_count_sparse_memory(&state_sparse),
+                wnd_bit_count_sparse_peak_memory(&state_sparse));
+
+            wnd_bit_count_sparse_destruct(&state_sparse);
+            wnd_bit_count_destruct(&state);
+        }
+    }
+}
+
 int main() {
     printf("**** TEST: Bit counting over a sliding window *****\n");
 
@@ -24,5 +187,10 @@ int main() {
 
     wnd_bit_count_destruct(&state);
 
+    test_idx();
+    test_runs();
+    test_reset();
+    test_sparse();
+
     return 0;
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
 
 typedef struct {
     uint32_t wnd_size;
@@ -13,23 +16,70 @@ typedef struct {
     uint32_t count;
 } State;
 
+/*
+ * Window buffers start out zeroed. Buffers of WND_MMAP_THRESHOLD bytes or more are mapped
+ * straight from the kernel, which zeroes a page only when it is first touched, so neither
+ * construction nor reset has to walk the whole buffer (malloc may hand out recycled heap
+ * memory that calloc then has to clear). Define WND_HUGE_PAGES to ask for transparent
+ * huge pages for these buffers, which also cuts the TLB misses of a large window.
+ */
+#define WND_MMAP_THRESHOLD (1 << 21)
+
+void* wnd_alloc_zeroed(uint64_t size) {
+    if (size < WND_MMAP_THRESHOLD) {
+        return calloc(1, size);
+    }
+    void* buffer = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED) {
+        return NULL;
+    }
+#ifdef WND_HUGE_PAGES
+    madvise(buffer, size, MADV_HUGEPAGE);
+#endif
+    return buffer;
+}
+
+void wnd_free_zeroed(void* buffer, uint64_t size) {
+    if (size < WND_MMAP_THRESHOLD) {
+        free(buffer);
+    } else {
+        munmap(buffer, size);
+    }
+}
+
+/*
+ * wnd_rezero zeroes a buffer from wnd_alloc_zeroed again. A mapped buffer gives its pages
+ * back to the kernel, so the cost is in the pages that were touched, not in the size.
+ */
+void wnd_rezero(void* buffer, uint64_t size) {
+    if (size < WND_MMAP_THRESHOLD || madvise(buffer, size, MADV_DONTNEED) != 0) {
+        memset(buffer, 0, size);
+    }
+}
+
 uint64_t wnd_bit_count_new(State* self, uint32_t wnd_size) {
     assert(wnd_size >= 1);
 
     self->wnd_size = wnd_size;
     self->index_oldest = 0;
     uint64_t memory = ((uint64_t) wnd_size) * sizeof(bool);
-    self->wnd_buffer = (bool*) malloc(memory);
-    for (uint32_t i=0; i<wnd_size; i++) {
-        self->wnd_buffer[i] = false;
-    }
+    self->wnd_buffer = (bool*) wnd_alloc_zeroed(memory);
     self->count = 0;
 
     return memory;
 }
 
 void wnd_bit_count_destruct(State* self) {
-    free(self->wnd_buffer);
+    wnd_free_zeroed(self->wnd_buffer, ((uint64_t) self->wnd_size) * sizeof(bool));
+}
+
+/*
+ * wnd_bit_count_reset empties the window and keeps its buffer for the next stream
+ */
+void wnd_bit_count_reset(State* self) {
+    wnd_rezero(self->wnd_buffer, ((uint64_t) self->wnd_size) * sizeof(bool));
+    self->index_oldest = 0;
+    self->count = 0;
 }
 
 void wnd_bit_count_print(State* self) {
@@ -50,4 +100,320 @@ uint32_t wnd_bit_count_next(State* self, bool item) {
     return self->count;
 }
 
+/*
+ * wnd_bit_count_next_batch feeds a buffer of bit-packed items into the window
+ * bits: the items, 8 per byte, least significant bit first
+ * n_items: the number of items in the buffer
+ * returns: the count of the bits in the window after the last item
+ */
+uint32_t wnd_bit_count_next_batch(State* self, const uint8_t* bits, uint64_t n_items) {
+    for (uint64_t i=0; i<n_items; i++) {
+        bool item = (bits[i >> 3] >> (i & 7)) & 1;
+        wnd_bit_count_next(self, item);
+    }
+    return self->count;
+}
+
+/*
+ * wnd_bit_count_next_run feeds a run of equal items into the window
+ * item: the value of the items
+ * run_length: the number of items
+ * returns: the count of the bits in the window after the last item
+ *
+ * The slots the run overwrites are counted and filled with memset one contiguous
+ * stretch of the ring at a time, and a run covering the whole window resets it
+ * without looking at the old items.
+ */
+uint32_t wnd_bit_count_next_run(State* self, bool item, uint64_t run_length) {
+    if (run_length >= self->wnd_size) {
+        memset(self->wnd_buffer, item, self->wnd_size);
+        self->count = item ? self->wnd_size : 0;
+        self->index_oldest = (self->index_oldest + run_length % self->wnd_size) % self->wnd_size;
+        return self->count;
+    }
+
+    uint32_t left = (uint32_t) run_length;
+    while (left > 0) {
+        uint32_t n = self->wnd_size - self->index_oldest;
+        if (n > left) {
+            n = left;
+        }
+        bool* slots = self->wnd_buffer + self->index_oldest;
+        uint32_t old = 0;
+        for (uint32_t i=0; i<n; i++) {
+            old += slots[i];
+        }
+        memset(slots, item, n);
+        self->count = self->count - old + (item ? n : 0);
+
+        self->index_oldest += n;
+        if (self->index_oldest == self->wnd_size) {
+            self->index_oldest = 0;
+        }
+        left -= n;
+    }
+
+    return self->count;
+}
+
+/*
+ * StateSparse is an exact window that stores only the positions of the ones in it.
+ *
+ * The positions are kept, oldest first, in a ring of 32-bit timestamps. The timestamps
+ * wrap around, which is fine because only differences smaller than the window size are
+ * compared. The ring doubles when it is full and halves when it is less than a quarter
+ * full, so its memory follows the number of ones in the window instead of the window
+ * size, and an update is O(1) amortized. The ring can be up to four times larger than the
+ * number of ones, 16 bytes per one, so it is guaranteed to take less memory than State
+ * only while fewer than 1 in 16 items are ones, and less than a bit-packed window below
+ * 1 in 128.
+ */
+#define SPARSE_MIN_CAPACITY 16
+
+typedef struct {
+    uint32_t wnd_size;
+    uint32_t time; // timestamp of the next item
+    uint32_t* positions;
+    uint32_t capacity; // always a power of two
+    uint32_t peak_capacity; // largest capacity since the window was created
+    uint32_t index_oldest; // index of the position of the oldest one
+    uint32_t count;
+} StateSparse;
+
+uint64_t wnd_bit_count_sparse_new(StateSparse* self, uint32_t wnd_size) {
+    assert(wnd_size >= 1);
+
+    self->wnd_size = wnd_size;
+    self->time = 0;
+    self->capacity = SPARSE_MIN_CAPACITY;
+    self->peak_capacity = self->capacity;
+    self->positions = (uint32_t*) malloc(self->capacity * sizeof(uint32_t));
+    self->index_oldest = 0;
+    self->count = 0;
+
+    return self->capacity * sizeof(uint32_t);
+}
+
+void wnd_bit_count_sparse_destruct(StateSparse* self) {
+    free(self->positions);
+}
+
+void wnd_bit_count_sparse_print(StateSparse* self) {
+    printf("count = %u, capacity = %u:", self->count, self->capacity);
+    for (uint32_t i=0; i<self->count; i++) {
+        printf(" %u", self->positions[(self->index_oldest + i) & (self->capacity - 1)]);
+    }
+    printf("\n");
+}
+
+/*
+ * wnd_bit_count_sparse_memory returns the number of bytes currently allocated on the heap,
+ * which changes as the ring grows and shrinks
+ */
+uint64_t wnd_bit_count_sparse_memory(StateSparse* self) {
+    return ((uint64_t) self->capacity) * sizeof(uint32_t);
+}
+
+/*
+ * wnd_bit_count_sparse_peak_memory returns the largest number of bytes the ring has taken
+ * since the window was created
+ */
+uint64_t wnd_bit_count_sparse_peak_memory(StateSparse* self) {
+    return ((uint64_t) self->peak_capacity) * sizeof(uint32_t);
+}
+
+void wnd_bit_count_sparse_resize(StateSparse* self, uint32_t capacity) {
+    uint32_t* positions = (uint32_t*) malloc(((uint64_t) capacity) * sizeof(uint32_t));
+    for (uint32_t i=0; i<self->count; i++) {
+        positions[i] = self->positions[(self->index_oldest + i) & (self->capacity - 1)];
+    }
+    free(self->positions);
+    self->positions = positions;
+    self->capacity = capacity;
+    if (capacity > self->peak_capacity) {
+        self->peak_capacity = capacity;
+    }
+    self->index_oldest = 0;
+}
+
+uint32_t wnd_bit_count_sparse_next(StateSparse* self, bool item) {
+    // at most one position leaves the window per item
+    if (self->count > 0 && self->time - self->positions[self->index_oldest] >= self->wnd_size) {
+        self->index_oldest = (self->index_oldest + 1) & (self->capacity - 1);
+        self->count -= 1;
+        if (self->capacity > SPARSE_MIN_CAPACITY && self->count < self->capacity / 4) {
+            wnd_bit_count_sparse_resize(self, self->capacity / 2);
+        }
+    }
+
+    if (item) {
+        if (self->count == self->capacity) {
+            wnd_bit_count_sparse_resize(self, self->capacity * 2);
+        }
+        self->positions[(self->index_oldest + self->count) & (self->capacity - 1)] = self->time;
+        self->count += 1;
+    }
+
+    self->time += 1;
+    return self->count;
+}
+
+/*
+ * wnd_bit_count_sparse_reset empties the window in O(1) and keeps the ring
+ */
+void wnd_bit_count_sparse_reset(StateSparse* self) {
+    self->time = 0;
+    self->index_oldest = 0;
+    self->count = 0;
+}
+
+/*
+ * StateIdx is an exact window that can also count the ones in any interval inside the window.
+ *
+ * The items are bit-packed into a ring of 64-bit words, grouped into blocks of
+ * IDX_BLOCK_WORDS words. For every block we keep the number of ones seen in the stream
+ * before the block started, which is set when the writer rotates into the block.
+ * The rank of an item (the number of ones before it) is then the prefix of its block
+ * plus a popcount over at most IDX_BLOCK_WORDS words, and a range count is the
+ * difference of two ranks, so it takes O(1) time. The prefixes cost 1/8 of the
+ * bit-packed window on top of it.
+ *
+ * The ring has room for at least one block more than the window, so the block
+ * holding the oldest item of the window is never the one being rewritten.
+ */
+#define IDX_BLOCK_WORDS 8
+#define IDX_BLOCK_BITS (64 * IDX_BLOCK_WORDS)
+
+typedef struct {
+    uint32_t wnd_size;
+    uint32_t n_blocks;
+    uint64_t* words;
+    uint64_t* block_prefix; // number of ones seen before the block started
+    uint64_t time; // number of items seen so far
+    uint64_t total; // number of ones seen so far
+    uint32_t count; // number of ones in the window
+    uint32_t head_block, head_bit; // where the next item is written
+    uint32_t tail_block, tail_bit; // where the item leaving the window is, once time >= wnd_size
+} StateIdx;
+
+uint64_t wnd_bit_count_idx_new(StateIdx* self, uint32_t wnd_size) {
+    assert(wnd_size >= 1);
+
+    self->wnd_size = wnd_size;
+    self->n_blocks = wnd_size / IDX_BLOCK_BITS + 2;
+    uint64_t words_memory = ((uint64_t) self->n_blocks) * IDX_BLOCK_WORDS * sizeof(uint64_t);
+    uint64_t prefix_memory = ((uint64_t) self->n_blocks) * sizeof(uint64_t);
+    self->words = (uint64_t*) calloc(1, words_memory);
+    self->block_prefix = (uint64_t*) calloc(1, prefix_memory);
+    self->time = 0;
+    self->total = 0;
+    self->count = 0;
+    self->head_block = 0;
+    self->head_bit = 0;
+    self->tail_block = 0;
+    self->tail_bit = 0;
+
+    return words_memory + prefix_memory;
+}
+
+void wnd_bit_count_idx_destruct(StateIdx* self) {
+    free(self->words);
+    free(self->block_prefix);
+}
+
+/*
+ * wnd_bit_count_idx_reset empties the window in O(1), the blocks are cleared when
+ * the writer rotates into them anyway
+ */
+void wnd_bit_count_idx_reset(StateIdx* self) {
+    self->time = 0;
+    self->total = 0;
+    self->count = 0;
+    self->head_block = 0;
+    self->head_bit = 0;
+    self->tail_block = 0;
+    self->tail_bit = 0;
+}
+
+void wnd_bit_count_idx_print(StateIdx* self) {
+    printf("time = %lu, count = %u, ones seen = %lu\n", self->time, self->count, self->total);
+}
+
+uint32_t wnd_bit_count_idx_next(StateIdx* self, bool item) {
+    uint64_t* block = self->words + ((uint64_t) self->head_block) * IDX_BLOCK_WORDS;
+    if (self->head_bit == 0) {
+        // rotate into the block, the items it holds left the window long ago
+        memset(block, 0, IDX_BLOCK_WORDS * sizeof(uint64_t));
+        self->block_prefix[self->head_block] = self->total;
+    }
+
+    if (self->time >= self->wnd_size) {
+        uint64_t* tail = self->words + ((uint64_t) self->tail_block) * IDX_BLOCK_WORDS;
+        self->count -= (tail[self->tail_bit >> 6] >> (self->tail_bit & 63)) & 1;
+        self->tail_bit += 1;
+        if (self->tail_bit == IDX_BLOCK_BITS) {
+            self->tail_bit = 0;
+            self->tail_block = self->tail_block + 1 == self->n_blocks ? 0 : self->tail_block + 1;
+        }
+    }
+
+    block[self->head_bit >> 6] |= ((uint64_t) item) << (self->head_bit & 63);
+    self->count += item;
+    self->total += item;
+    self->time += 1;
+
+    self->head_bit += 1;
+    if (self->head_bit == IDX_BLOCK_BITS) {
+        self->head_bit = 0;
+        self->head_block = self->head_block + 1 == self->n_blocks ? 0 : self->head_block + 1;
+    }
+
+    return self->count;
+}
+
+/*
+ * wnd_bit_count_idx_rank counts the ones among the items seen before time t
+ * t: the time of an item still in the ring, or the current time
+ */
+uint64_t wnd_bit_count_idx_rank(StateIdx* self, uint64_t t) {
+    if (t == self->time) {
+        // the block of t may not have been rotated into yet
+        return self->total;
+    }
+    uint32_t slot = (t / IDX_BLOCK_BITS) % self->n_blocks;
+    uint32_t bit = t % IDX_BLOCK_BITS;
+    uint64_t* block = self->words + ((uint64_t) slot) * IDX_BLOCK_WORDS;
+
+    uint64_t rank = self->block_prefix[slot];
+    for (uint32_t i=0; i<(bit >> 6); i++) {
+        rank += __builtin_popcountll(block[i]);
+    }
+    if (bit & 63) {
+        rank += __builtin_popcountll(block[bit >> 6] & ((1ULL << (bit & 63)) - 1));
+    }
+    return rank;
+}
+
+/*
+ * wnd_bit_count_idx_range counts the ones in an interval of the window
+ * from, to: the ages of the items, from inclusive and to exclusive, where the most
+ *           recent item has age 0 and the oldest item of the window has age wnd_size - 1
+ * returns: the count of the bits with age in [from, to)
+ */
+uint32_t wnd_bit_count_idx_range(StateIdx* self, uint32_t from, uint32_t to) {
+    assert(from <= to && to <= self->wnd_size);
+
+    // items that were never seen count as zeros
+    uint64_t end = from <= self->time ? self->time - from : 0;
+    uint64_t begin = to <= self->time ? self->time - to : 0;
+    return (uint32_t) (wnd_bit_count_idx_rank(self, end) - wnd_bit_count_idx_rank(self, begin));
+}
+
+/*
+ * wnd_bit_count_idx_last counts the ones in the last w items, w <= wnd_size
+ */
+uint32_t wnd_bit_count_idx_last(StateIdx* self, uint32_t w) {
+    return wnd_bit_count_idx_range(self, 0, w);
+}
+
 #endif // _WINDOW_BIT_COUNT_